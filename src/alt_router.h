@@ -0,0 +1,238 @@
+#pragma once
+
+#include "frozen_graph.h"
+#include "router_base.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// A* search with landmark lower bounds (ALT). Distances from and to a few landmark vertices give
+// a lower bound of the remaining route by the triangle inequality. An optional external lower bound
+// (for example the straight line distance divided by the top speed) is combined with it
+template <typename Weight>
+class AltRouter : public RouterBase<Weight> {
+private:
+    using Graph = FrozenGraph<Weight>;
+    using ArcId = typename Graph::ArcId;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+    // Must never exceed the weight of any route between the vertices
+    using LowerBound = std::function<Weight(VertexId from, VertexId to)>;
+
+    explicit AltRouter(const Graph& graph, size_t landmark_count = DEFAULT_LANDMARK_COUNT,
+                       LowerBound lower_bound = nullptr);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    using EdgeChanges = typename RouterBase<Weight>::EdgeChanges;
+
+    // The owner freezes the changed graph into the same object. Routes only get heavier if no edge got lighter,
+    // so the landmark weights still bound them from below and are kept; otherwise the router is built again.
+    // The external lower bound has to stay valid as well
+    bool Update(const EdgeChanges& changes) override;
+
+    size_t GetMemoryUsage() const override;
+
+    static constexpr size_t DEFAULT_LANDMARK_COUNT = 8;
+
+private:
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    // Weights of the routes from the landmark to every vertex of the graph, over the transposed graph
+    // these are the weights of the routes to the landmark
+    static std::vector<Weight> ComputeWeights(const Graph& graph, VertexId landmark);
+    // std::nullopt when the landmarks prove that there is no route at all
+    std::optional<Weight> EstimateRest(VertexId vertex, VertexId to) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight UNREACHED = std::numeric_limits<Weight>::max();
+
+    const Graph& graph_;
+    LowerBound lower_bound_;
+    size_t landmark_count_ = 0;
+    // Landmark-major tables: weights_from_landmarks_[i * vertex_count + v] is the weight of the route
+    // from the i-th landmark to v, weights_to_landmarks_ of the route from v to it
+    std::vector<Weight> weights_from_landmarks_;
+    std::vector<Weight> weights_to_landmarks_;
+};
+
+template <typename Weight>
+AltRouter<Weight>::AltRouter(const Graph& graph, size_t landmark_count, LowerBound lower_bound)
+    : graph_(graph)
+    , lower_bound_(std::move(lower_bound))
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    for (ArcId arc = 0; arc < graph.GetArcCount(); ++arc) {
+        if (graph.GetWeight(arc) < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    const Graph transposed_graph = graph.Transpose();
+
+    landmark_count = std::min(landmark_count, vertex_count);
+    weights_from_landmarks_.reserve(landmark_count * vertex_count);
+    weights_to_landmarks_.reserve(landmark_count * vertex_count);
+
+    // Farthest landmark selection: each next landmark is the vertex worst covered by the previous ones,
+    // vertices unreachable from all of them come first
+    std::vector<Weight> nearest_landmark_weights(vertex_count, UNREACHED);
+    VertexId landmark = 0;
+    for (size_t i = 0; i < landmark_count; ++i) {
+        const auto weights_from = ComputeWeights(graph, landmark);
+        const auto weights_to = ComputeWeights(transposed_graph, landmark);
+        weights_from_landmarks_.insert(weights_from_landmarks_.end(), weights_from.begin(), weights_from.end());
+        weights_to_landmarks_.insert(weights_to_landmarks_.end(), weights_to.begin(), weights_to.end());
+        ++landmark_count_;
+
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            nearest_landmark_weights[vertex] = std::min(nearest_landmark_weights[vertex], weights_from[vertex]);
+        }
+        // A landmark has zero weight to itself, so it is never picked twice
+        landmark = std::max_element(nearest_landmark_weights.begin(), nearest_landmark_weights.end())
+            - nearest_landmark_weights.begin();
+        if (nearest_landmark_weights[landmark] == ZERO_WEIGHT) {
+            break;
+        }
+    }
+}
+
+template <typename Weight>
+std::vector<Weight> AltRouter<Weight>::ComputeWeights(const Graph& graph, VertexId landmark) {
+    std::vector<Weight> weights(graph.GetVertexCount(), UNREACHED);
+    Queue queue;
+    weights[landmark] = ZERO_WEIGHT;
+    queue.push({ZERO_WEIGHT, landmark});
+
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weights[vertex] < weight) {
+            continue;
+        }
+        for (const ArcId arc : graph.GetArcs(vertex)) {
+            const VertexId next = graph.GetTarget(arc);
+            const Weight candidate_weight = weight + graph.GetWeight(arc);
+            if (candidate_weight < weights[next]) {
+                weights[next] = candidate_weight;
+                queue.push({candidate_weight, next});
+            }
+        }
+    }
+    return weights;
+}
+
+template <typename Weight>
+std::optional<Weight> AltRouter<Weight>::EstimateRest(VertexId vertex, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    Weight estimate = lower_bound_ ? lower_bound_(vertex, to) : ZERO_WEIGHT;
+
+    for (size_t i = 0; i < landmark_count_; ++i) {
+        const Weight* weights_from = weights_from_landmarks_.data() + i * vertex_count;
+        const Weight* weights_to = weights_to_landmarks_.data() + i * vertex_count;
+
+        // route(vertex, landmark) <= route(vertex, to) + route(to, landmark)
+        if (weights_to[to] != UNREACHED) {
+            if (weights_to[vertex] == UNREACHED) {
+                return std::nullopt;
+            }
+            estimate = std::max(estimate, weights_to[vertex] - weights_to[to]);
+        }
+        // route(landmark, to) <= route(landmark, vertex) + route(vertex, to)
+        if (weights_from[vertex] != UNREACHED) {
+            if (weights_from[to] == UNREACHED) {
+                return std::nullopt;
+            }
+            estimate = std::max(estimate, weights_from[to] - weights_from[vertex]);
+        }
+    }
+    return estimate;
+}
+
+template <typename Weight>
+std::optional<typename AltRouter<Weight>::RouteInfo> AltRouter<Weight>::BuildRoute(VertexId from,
+                                                                                   VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+
+    std::vector<Weight> weights(vertex_count, UNREACHED);
+    std::vector<std::optional<ArcId>> prev_arcs(vertex_count);
+    // The estimate of every vertex is computed once, on its first reach
+    std::vector<std::optional<Weight>> estimates(vertex_count);
+    Queue queue;
+
+    const auto start_estimate = EstimateRest(from, to);
+    if (!start_estimate) {
+        return std::nullopt;
+    }
+    weights[from] = ZERO_WEIGHT;
+    estimates[from] = start_estimate;
+    queue.push({*start_estimate, from});
+
+    while (!queue.empty()) {
+        const auto [key, vertex] = queue.top();
+        queue.pop();
+        const Weight weight = weights[vertex];
+        if (weight + *estimates[vertex] < key) {
+            continue;
+        }
+        if (vertex == to) {
+            break;
+        }
+        for (const ArcId arc : graph_.GetArcs(vertex)) {
+            const VertexId next = graph_.GetTarget(arc);
+            const Weight candidate_weight = weight + graph_.GetWeight(arc);
+            if (candidate_weight >= weights[next]) {
+                continue;
+            }
+            if (!estimates[next]) {
+                estimates[next] = EstimateRest(next, to).value_or(UNREACHED);
+            }
+            // The landmarks prove that the target is unreachable from there
+            if (*estimates[next] == UNREACHED) {
+                continue;
+            }
+            weights[next] = candidate_weight;
+            prev_arcs[next] = arc;
+            queue.push({candidate_weight + *estimates[next], next});
+        }
+    }
+
+    if (weights[to] == UNREACHED) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (std::optional<ArcId> arc = prev_arcs[to];
+         arc;
+         arc = prev_arcs[graph_.GetSource(*arc)])
+    {
+        edges.push_back(graph_.GetEdgeId(*arc));
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{weights[to], std::move(edges)};
+}
+
+template <typename Weight>
+bool AltRouter<Weight>::Update(const EdgeChanges& changes) {
+    return changes.decreased.empty() && graph_.GetVertexCount() * landmark_count_ == weights_from_landmarks_.size();
+}
+
+template <typename Weight>
+size_t AltRouter<Weight>::GetMemoryUsage() const {
+    return (weights_from_landmarks_.capacity() + weights_to_landmarks_.capacity()) * sizeof(Weight);
+}
+
+}  // namespace graph
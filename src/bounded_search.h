@@ -0,0 +1,77 @@
+#pragma once
+
+#include "frozen_graph.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Every vertex whose route from the source weighs at most max_weight, with that weight, in the order of weight.
+// The search stops as soon as the frontier passes the budget. Its scratch arrays live per thread and only
+// the touched entries are reset, so repeated queries allocate nothing and cost O(reached area)
+template <typename Weight>
+std::vector<std::pair<VertexId, Weight>> FindReachableVertexes(const FrozenGraph<Weight>& graph, VertexId from,
+                                                               Weight max_weight) {
+    using QueueItem = std::pair<Weight, VertexId>;
+    static constexpr Weight UNREACHED = std::numeric_limits<Weight>::max();
+
+    thread_local std::vector<Weight> weights;
+    thread_local std::vector<VertexId> touched_vertexes;
+    // Binary heap kept with std::push_heap / std::pop_heap, so its storage survives between queries
+    thread_local std::vector<QueueItem> queue;
+
+    const size_t vertex_count = graph.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+    if (weights.size() < vertex_count) {
+        weights.resize(vertex_count, UNREACHED);
+    }
+
+    std::vector<std::pair<VertexId, Weight>> reached;
+    if (max_weight < Weight{}) {
+        return reached;
+    }
+
+    const std::greater<QueueItem> compare;
+    weights[from] = Weight{};
+    touched_vertexes.push_back(from);
+    queue.push_back({Weight{}, from});
+
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), compare);
+        const auto [weight, vertex] = queue.back();
+        queue.pop_back();
+        if (weights[vertex] < weight) {
+            continue;
+        }
+        reached.push_back({vertex, weight});
+        for (const auto arc : graph.GetArcs(vertex)) {
+            const VertexId next = graph.GetTarget(arc);
+            const Weight candidate_weight = weight + graph.GetWeight(arc);
+            // Anything over the budget is never pushed, so the queue runs dry right at the frontier
+            if (candidate_weight > max_weight || candidate_weight >= weights[next]) {
+                continue;
+            }
+            if (weights[next] == UNREACHED) {
+                touched_vertexes.push_back(next);
+            }
+            weights[next] = candidate_weight;
+            queue.push_back({candidate_weight, next});
+            std::push_heap(queue.begin(), queue.end(), compare);
+        }
+    }
+
+    for (const VertexId vertex : touched_vertexes) {
+        weights[vertex] = UNREACHED;
+    }
+    touched_vertexes.clear();
+    return reached;
+}
+
+}  // namespace graph
@@ -0,0 +1,504 @@
+#pragma once
+
+#include "graph.h"
+#include "router_base.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Contraction Hierarchies: vertices are contracted one by one in the order of their importance,
+// shortcuts keep the distances between the remaining vertices. A query is a bidirectional search
+// that only goes up the hierarchy, shortcuts are unpacked back to the original edge ids
+template <typename Weight>
+class ContractionHierarchy : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using ArcId = size_t;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    explicit ContractionHierarchy(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    using RouteMatrix = typename RouterBase<Weight>::RouteMatrix;
+
+    // Bucket-based many-to-many: one backward upward search per target fills the buckets of the vertices
+    // it reaches, then one forward upward search per source scans the buckets
+    RouteMatrix BuildRoutes(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets) const override;
+
+    size_t GetMemoryUsage() const override;
+
+    size_t GetShortcutCount() const;
+
+private:
+    // Either an edge of the original graph or a shortcut made of two arcs through a contracted vertex
+    struct Arc {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        std::optional<EdgeId> edge_id;
+        ArcId first = 0;
+        ArcId second = 0;
+    };
+
+    // Adjacency of the vertices that are not contracted yet, only the best arc to every neighbour is kept
+    struct ContractionState {
+        std::vector<std::vector<std::pair<VertexId, ArcId>>> out_arcs;
+        std::vector<std::vector<std::pair<VertexId, ArcId>>> in_arcs;
+        std::vector<bool> contracted;
+        std::vector<int> contracted_neighbours;
+        std::vector<Weight> witness_weights;
+        std::vector<VertexId> witness_touched;
+    };
+
+    struct BucketEntry {
+        size_t target_index;
+        Weight weight;
+        std::optional<ArcId> next_arc;
+    };
+
+    // Buffers of a complete upward search, reused between the searches of one query
+    struct SearchScratch {
+        std::vector<Weight> weights;
+        std::vector<std::optional<ArcId>> arcs;
+        std::vector<VertexId> touched;
+        std::vector<VertexId> settled;
+    };
+
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    void RunUpwardSearch(VertexId start, bool forward, SearchScratch& scratch) const;
+    void ResetUpwardSearch(SearchScratch& scratch) const;
+    void AddOrUpdateArc(ContractionState& state, Arc arc);
+    void RunWitnessSearch(ContractionState& state, VertexId source, VertexId excluded, Weight max_weight) const;
+    void ResetWitnessSearch(ContractionState& state) const;
+    int ContractVertex(ContractionState& state, VertexId vertex, bool simulate);
+    int ComputePriority(ContractionState& state, VertexId vertex);
+    void UnpackArc(ArcId arc_id, std::vector<EdgeId>& edges) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight UNREACHED = std::numeric_limits<Weight>::max();
+    static constexpr size_t WITNESS_SETTLED_LIMIT = 50;
+
+    size_t original_arc_count_ = 0;
+    std::vector<Arc> arcs_;
+    // Arcs from the vertex to the vertices contracted later
+    std::vector<std::vector<ArcId>> upward_arcs_;
+    // Arcs into the vertex from the vertices contracted later
+    std::vector<std::vector<ArcId>> downward_arcs_;
+};
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+    : upward_arcs_(graph.GetVertexCount())
+    , downward_arcs_(graph.GetVertexCount())
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    ContractionState state;
+    state.out_arcs.resize(vertex_count);
+    state.in_arcs.resize(vertex_count);
+    state.contracted.assign(vertex_count, false);
+    state.contracted_neighbours.assign(vertex_count, 0);
+    state.witness_weights.assign(vertex_count, UNREACHED);
+
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            if (edge.from != edge.to) {
+                AddOrUpdateArc(state, {edge.from, edge.to, edge.weight, edge_id});
+            }
+        }
+    }
+    original_arc_count_ = arcs_.size();
+
+    Queue order;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        order.push({static_cast<Weight>(ComputePriority(state, vertex)), vertex});
+    }
+
+    while (!order.empty()) {
+        const VertexId vertex = order.top().second;
+        order.pop();
+        if (state.contracted[vertex]) {
+            continue;
+        }
+        // Priorities change as neighbours get contracted, so they are refreshed lazily
+        const Weight priority = static_cast<Weight>(ComputePriority(state, vertex));
+        if (!order.empty() && priority > order.top().first) {
+            order.push({priority, vertex});
+            continue;
+        }
+        ContractVertex(state, vertex, false);
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::AddOrUpdateArc(ContractionState& state, Arc arc) {
+    auto& out_arcs = state.out_arcs[arc.from];
+    auto it = std::find_if(out_arcs.begin(), out_arcs.end(), [&arc](const auto& item) {
+        return item.first == arc.to;
+    });
+    if (it != out_arcs.end() && arcs_[it->second].weight <= arc.weight) {
+        return;
+    }
+
+    // Arcs are never modified in place, older shortcuts may still be unpacked through them
+    const ArcId arc_id = arcs_.size();
+    arcs_.push_back(arc);
+    if (it != out_arcs.end()) {
+        it->second = arc_id;
+        auto& in_arcs = state.in_arcs[arc.to];
+        std::find_if(in_arcs.begin(), in_arcs.end(), [&arc](const auto& item) {
+            return item.first == arc.from;
+        })->second = arc_id;
+    }
+    else {
+        out_arcs.push_back({arc.to, arc_id});
+        state.in_arcs[arc.to].push_back({arc.from, arc_id});
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::RunWitnessSearch(ContractionState& state, VertexId source, VertexId excluded,
+                                                    Weight max_weight) const {
+    Queue queue;
+    state.witness_weights[source] = ZERO_WEIGHT;
+    state.witness_touched.push_back(source);
+    queue.push({ZERO_WEIGHT, source});
+
+    size_t settled = 0;
+    while (!queue.empty() && settled < WITNESS_SETTLED_LIMIT) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (state.witness_weights[vertex] < weight) {
+            continue;
+        }
+        ++settled;
+        for (const auto& [next, arc_id] : state.out_arcs[vertex]) {
+            if (next == excluded) {
+                continue;
+            }
+            const Weight candidate_weight = weight + arcs_[arc_id].weight;
+            if (candidate_weight <= max_weight && candidate_weight < state.witness_weights[next]) {
+                if (state.witness_weights[next] == UNREACHED) {
+                    state.witness_touched.push_back(next);
+                }
+                state.witness_weights[next] = candidate_weight;
+                queue.push({candidate_weight, next});
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::ResetWitnessSearch(ContractionState& state) const {
+    for (const VertexId vertex : state.witness_touched) {
+        state.witness_weights[vertex] = UNREACHED;
+    }
+    state.witness_touched.clear();
+}
+
+template <typename Weight>
+int ContractionHierarchy<Weight>::ContractVertex(ContractionState& state, VertexId vertex, bool simulate) {
+    int shortcut_count = 0;
+    // Adding shortcuts never touches the arcs of the contracted vertex itself
+    const auto& in_arcs = state.in_arcs[vertex];
+    const auto& out_arcs = state.out_arcs[vertex];
+
+    for (const auto& [from, in_arc_id] : in_arcs) {
+        const Weight in_weight = arcs_[in_arc_id].weight;
+        Weight max_out_weight = ZERO_WEIGHT;
+        bool has_targets = false;
+        for (const auto& [to, out_arc_id] : out_arcs) {
+            if (to != from) {
+                max_out_weight = std::max(max_out_weight, arcs_[out_arc_id].weight);
+                has_targets = true;
+            }
+        }
+        if (!has_targets) {
+            continue;
+        }
+
+        RunWitnessSearch(state, from, vertex, in_weight + max_out_weight);
+        for (const auto& [to, out_arc_id] : out_arcs) {
+            if (to == from) {
+                continue;
+            }
+            const Weight shortcut_weight = in_weight + arcs_[out_arc_id].weight;
+            if (state.witness_weights[to] <= shortcut_weight) {
+                continue;
+            }
+            ++shortcut_count;
+            if (!simulate) {
+                AddOrUpdateArc(state, {from, to, shortcut_weight, std::nullopt, in_arc_id, out_arc_id});
+            }
+        }
+        ResetWitnessSearch(state);
+    }
+
+    if (!simulate) {
+        const auto is_vertex = [vertex](const auto& item) {
+            return item.first == vertex;
+        };
+        state.contracted[vertex] = true;
+        for (const auto& [from, arc_id] : in_arcs) {
+            downward_arcs_[vertex].push_back(arc_id);
+            ++state.contracted_neighbours[from];
+            std::erase_if(state.out_arcs[from], is_vertex);
+        }
+        for (const auto& [to, arc_id] : out_arcs) {
+            upward_arcs_[vertex].push_back(arc_id);
+            ++state.contracted_neighbours[to];
+            std::erase_if(state.in_arcs[to], is_vertex);
+        }
+        state.in_arcs[vertex].clear();
+        state.out_arcs[vertex].clear();
+    }
+    return shortcut_count;
+}
+
+template <typename Weight>
+int ContractionHierarchy<Weight>::ComputePriority(ContractionState& state, VertexId vertex) {
+    const size_t arc_count = state.in_arcs[vertex].size() + state.out_arcs[vertex].size();
+    const int edge_difference = ContractVertex(state, vertex, true) - static_cast<int>(arc_count);
+    return edge_difference + state.contracted_neighbours[vertex];
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchy<Weight>::RouteInfo>
+ContractionHierarchy<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = upward_arcs_.size();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+    if (from == to) {
+        return RouteInfo{ZERO_WEIGHT, {}};
+    }
+
+    std::vector<Weight> forward_weights(vertex_count, UNREACHED);
+    std::vector<Weight> backward_weights(vertex_count, UNREACHED);
+    std::vector<std::optional<ArcId>> forward_prev_arcs(vertex_count);
+    std::vector<std::optional<ArcId>> backward_next_arcs(vertex_count);
+    Queue forward_queue;
+    Queue backward_queue;
+
+    forward_weights[from] = ZERO_WEIGHT;
+    forward_queue.push({ZERO_WEIGHT, from});
+    backward_weights[to] = ZERO_WEIGHT;
+    backward_queue.push({ZERO_WEIGHT, to});
+
+    Weight best_weight = UNREACHED;
+    std::optional<VertexId> meeting_vertex;
+
+    while (!forward_queue.empty() || !backward_queue.empty()) {
+        const bool go_forward = backward_queue.empty()
+            || (!forward_queue.empty() && forward_queue.top().first <= backward_queue.top().first);
+        auto& queue = go_forward ? forward_queue : backward_queue;
+        auto& weights = go_forward ? forward_weights : backward_weights;
+        const auto& other_weights = go_forward ? backward_weights : forward_weights;
+
+        const auto [weight, vertex] = queue.top();
+        if (weight >= best_weight) {
+            break;
+        }
+        queue.pop();
+        if (weights[vertex] < weight) {
+            continue;
+        }
+        if (other_weights[vertex] != UNREACHED && weight + other_weights[vertex] < best_weight) {
+            best_weight = weight + other_weights[vertex];
+            meeting_vertex = vertex;
+        }
+
+        for (const ArcId arc_id : go_forward ? upward_arcs_[vertex] : downward_arcs_[vertex]) {
+            const auto& arc = arcs_[arc_id];
+            const VertexId next = go_forward ? arc.to : arc.from;
+            const Weight candidate_weight = weight + arc.weight;
+            if (candidate_weight < weights[next]) {
+                weights[next] = candidate_weight;
+                (go_forward ? forward_prev_arcs : backward_next_arcs)[next] = arc_id;
+                queue.push({candidate_weight, next});
+            }
+        }
+    }
+
+    if (!meeting_vertex) {
+        return std::nullopt;
+    }
+
+    std::vector<ArcId> path;
+    for (auto arc_id = forward_prev_arcs[*meeting_vertex]; arc_id; arc_id = forward_prev_arcs[arcs_[*arc_id].from]) {
+        path.push_back(*arc_id);
+    }
+    std::reverse(path.begin(), path.end());
+    for (auto arc_id = backward_next_arcs[*meeting_vertex]; arc_id; arc_id = backward_next_arcs[arcs_[*arc_id].to]) {
+        path.push_back(*arc_id);
+    }
+
+    std::vector<EdgeId> edges;
+    for (const ArcId arc_id : path) {
+        UnpackArc(arc_id, edges);
+    }
+    return RouteInfo{best_weight, std::move(edges)};
+}
+
+template <typename Weight>
+typename ContractionHierarchy<Weight>::RouteMatrix ContractionHierarchy<Weight>::BuildRoutes(
+    const std::vector<VertexId>& sources, const std::vector<VertexId>& targets) const {
+    const size_t vertex_count = upward_arcs_.size();
+    const auto is_out_of_range = [vertex_count](VertexId vertex) {
+        return vertex >= vertex_count;
+    };
+    if (std::any_of(sources.begin(), sources.end(), is_out_of_range)
+        || std::any_of(targets.begin(), targets.end(), is_out_of_range)) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+
+    SearchScratch scratch{std::vector<Weight>(vertex_count, UNREACHED),
+                          std::vector<std::optional<ArcId>>(vertex_count), {}, {}};
+    std::vector<std::vector<BucketEntry>> buckets(vertex_count);
+    for (size_t target_index = 0; target_index < targets.size(); ++target_index) {
+        RunUpwardSearch(targets[target_index], false, scratch);
+        for (const VertexId vertex : scratch.settled) {
+            buckets[vertex].push_back({target_index, scratch.weights[vertex], scratch.arcs[vertex]});
+        }
+        ResetUpwardSearch(scratch);
+    }
+
+    RouteMatrix routes(sources.size());
+    std::vector<Weight> best_weights(targets.size());
+    std::vector<std::optional<VertexId>> meeting_vertices(targets.size());
+    for (size_t source_index = 0; source_index < sources.size(); ++source_index) {
+        RunUpwardSearch(sources[source_index], true, scratch);
+        std::fill(best_weights.begin(), best_weights.end(), UNREACHED);
+        std::fill(meeting_vertices.begin(), meeting_vertices.end(), std::nullopt);
+        for (const VertexId vertex : scratch.settled) {
+            for (const auto& entry : buckets[vertex]) {
+                const Weight candidate_weight = scratch.weights[vertex] + entry.weight;
+                if (candidate_weight < best_weights[entry.target_index]) {
+                    best_weights[entry.target_index] = candidate_weight;
+                    meeting_vertices[entry.target_index] = vertex;
+                }
+            }
+        }
+
+        routes[source_index].resize(targets.size());
+        for (size_t target_index = 0; target_index < targets.size(); ++target_index) {
+            if (!meeting_vertices[target_index]) {
+                continue;
+            }
+            std::vector<ArcId> path;
+            for (auto arc_id = scratch.arcs[*meeting_vertices[target_index]]; arc_id;
+                 arc_id = scratch.arcs[arcs_[*arc_id].from]) {
+                path.push_back(*arc_id);
+            }
+            std::reverse(path.begin(), path.end());
+            // The backward part of the route is stored in the buckets of the target
+            for (VertexId vertex = *meeting_vertices[target_index];;) {
+                const auto& bucket = buckets[vertex];
+                const auto entry = std::find_if(bucket.begin(), bucket.end(), [target_index](const auto& item) {
+                    return item.target_index == target_index;
+                });
+                if (!entry->next_arc) {
+                    break;
+                }
+                path.push_back(*entry->next_arc);
+                vertex = arcs_[*entry->next_arc].to;
+            }
+
+            std::vector<EdgeId> edges;
+            for (const ArcId arc_id : path) {
+                UnpackArc(arc_id, edges);
+            }
+            routes[source_index][target_index] = RouteInfo{best_weights[target_index], std::move(edges)};
+        }
+        ResetUpwardSearch(scratch);
+    }
+    return routes;
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::RunUpwardSearch(VertexId start, bool forward, SearchScratch& scratch) const {
+    Queue queue;
+    scratch.weights[start] = ZERO_WEIGHT;
+    scratch.touched.push_back(start);
+    queue.push({ZERO_WEIGHT, start});
+
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (scratch.weights[vertex] < weight) {
+            continue;
+        }
+        scratch.settled.push_back(vertex);
+        for (const ArcId arc_id : forward ? upward_arcs_[vertex] : downward_arcs_[vertex]) {
+            const auto& arc = arcs_[arc_id];
+            const VertexId next = forward ? arc.to : arc.from;
+            const Weight candidate_weight = weight + arc.weight;
+            if (candidate_weight < scratch.weights[next]) {
+                if (scratch.weights[next] == UNREACHED) {
+                    scratch.touched.push_back(next);
+                }
+                scratch.weights[next] = candidate_weight;
+                scratch.arcs[next] = arc_id;
+                queue.push({candidate_weight, next});
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::ResetUpwardSearch(SearchScratch& scratch) const {
+    for (const VertexId vertex : scratch.touched) {
+        scratch.weights[vertex] = UNREACHED;
+        scratch.arcs[vertex] = std::nullopt;
+    }
+    scratch.touched.clear();
+    scratch.settled.clear();
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::UnpackArc(ArcId arc_id, std::vector<EdgeId>& edges) const {
+    std::vector<ArcId> stack{arc_id};
+    while (!stack.empty()) {
+        const auto& arc = arcs_[stack.back()];
+        stack.pop_back();
+        if (arc.edge_id) {
+            edges.push_back(*arc.edge_id);
+        }
+        else {
+            stack.push_back(arc.second);
+            stack.push_back(arc.first);
+        }
+    }
+}
+
+template <typename Weight>
+size_t ContractionHierarchy<Weight>::GetMemoryUsage() const {
+    size_t memory = arcs_.capacity() * sizeof(Arc);
+    for (VertexId vertex = 0; vertex < upward_arcs_.size(); ++vertex) {
+        memory += (upward_arcs_[vertex].capacity() + downward_arcs_[vertex].capacity()) * sizeof(ArcId);
+    }
+    return memory + 2 * upward_arcs_.size() * sizeof(std::vector<ArcId>);
+}
+
+template <typename Weight>
+size_t ContractionHierarchy<Weight>::GetShortcutCount() const {
+    return arcs_.size() - original_arc_count_;
+}
+
+}  // namespace graph
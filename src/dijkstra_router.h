@@ -0,0 +1,179 @@
+#pragma once
+
+#include "frozen_graph.h"
+#include "router_base.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Answers every query with its own single-source Dijkstra search over the frozen graph.
+// Nothing is precomputed, so construction is instant and memory stays O(V + E)
+template <typename Weight>
+class DijkstraRouter : public RouterBase<Weight> {
+private:
+    using Graph = FrozenGraph<Weight>;
+    using ArcId = typename Graph::ArcId;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    using RouteMatrix = typename RouterBase<Weight>::RouteMatrix;
+
+    // One search per source, it stops once all the targets are reached
+    RouteMatrix BuildRoutes(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets) const override;
+
+    using EdgeChanges = typename RouterBase<Weight>::EdgeChanges;
+
+    // Nothing is cached: the owner freezes the changed graph into the same object, and every next search sees it
+    bool Update(const EdgeChanges& changes) override;
+
+    size_t GetMemoryUsage() const override;
+
+private:
+    // Scratch buffers of a single search, owned by the query
+    struct RouteTree {
+        std::vector<Weight> weights;
+        std::vector<std::optional<ArcId>> prev_arcs;
+    };
+
+    RouteTree BuildRouteTree(VertexId from, const std::vector<VertexId>& targets) const;
+    std::optional<RouteInfo> ExtractRoute(const RouteTree& tree, VertexId to) const;
+
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight UNREACHED = std::numeric_limits<Weight>::max();
+
+    void CheckWeights() const;
+
+    const Graph& graph_;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+{
+    CheckWeights();
+}
+
+template <typename Weight>
+void DijkstraRouter<Weight>::CheckWeights() const {
+    for (ArcId arc = 0; arc < graph_.GetArcCount(); ++arc) {
+        if (graph_.GetWeight(arc) < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+                                                                                             VertexId to) const {
+    return ExtractRoute(BuildRouteTree(from, {to}), to);
+}
+
+template <typename Weight>
+typename DijkstraRouter<Weight>::RouteMatrix DijkstraRouter<Weight>::BuildRoutes(
+    const std::vector<VertexId>& sources, const std::vector<VertexId>& targets) const {
+    RouteMatrix routes(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const RouteTree tree = BuildRouteTree(sources[i], targets);
+        routes[i].reserve(targets.size());
+        for (const VertexId to : targets) {
+            routes[i].push_back(ExtractRoute(tree, to));
+        }
+    }
+    return routes;
+}
+
+template <typename Weight>
+typename DijkstraRouter<Weight>::RouteTree DijkstraRouter<Weight>::BuildRouteTree(
+    VertexId from, const std::vector<VertexId>& targets) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+
+    RouteTree tree{std::vector<Weight>(vertex_count, UNREACHED), std::vector<std::optional<ArcId>>(vertex_count)};
+    std::vector<bool> is_target(vertex_count, false);
+    size_t targets_left = 0;
+    for (const VertexId to : targets) {
+        if (to >= vertex_count) {
+            throw std::out_of_range("Vertex is out of range");
+        }
+        if (!is_target[to]) {
+            is_target[to] = true;
+            ++targets_left;
+        }
+    }
+    Queue queue;
+
+    tree.weights[from] = ZERO_WEIGHT;
+    queue.push({ZERO_WEIGHT, from});
+
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (tree.weights[vertex] < weight) {
+            continue;
+        }
+        // The search stops as soon as the routes to all targets are final
+        if (is_target[vertex] && --targets_left == 0) {
+            break;
+        }
+        for (const ArcId arc : graph_.GetArcs(vertex)) {
+            const VertexId next = graph_.GetTarget(arc);
+            const Weight candidate_weight = weight + graph_.GetWeight(arc);
+            if (candidate_weight < tree.weights[next]) {
+                tree.weights[next] = candidate_weight;
+                tree.prev_arcs[next] = arc;
+                queue.push({candidate_weight, next});
+            }
+        }
+    }
+    return tree;
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::ExtractRoute(const RouteTree& tree,
+                                                                                               VertexId to) const {
+    if (tree.weights[to] == UNREACHED) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (std::optional<ArcId> arc = tree.prev_arcs[to];
+         arc;
+         arc = tree.prev_arcs[graph_.GetSource(*arc)])
+    {
+        edges.push_back(graph_.GetEdgeId(*arc));
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{tree.weights[to], std::move(edges)};
+}
+
+template <typename Weight>
+bool DijkstraRouter<Weight>::Update(const EdgeChanges&) {
+    CheckWeights();
+    return true;
+}
+
+template <typename Weight>
+size_t DijkstraRouter<Weight>::GetMemoryUsage() const {
+    return 0;
+}
+
+}  // namespace graph
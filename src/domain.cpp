@@ -1 +1,19 @@
-#include "domain.h"
\ No newline at end of file
+#include "domain.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double TIME_TOLERANCE = 1e-9;
+
+bool IsSameItem(const RouteItems& lhs, const RouteItems& rhs) {
+	return lhs.type == rhs.type && lhs.name == rhs.name && lhs.span_count == rhs.span_count
+		&& std::abs(lhs.time - rhs.time) <= TIME_TOLERANCE * std::max({ 1.0, std::abs(lhs.time), std::abs(rhs.time) });
+}
+
+}  // namespace
+
+bool IsSameTrip(const std::vector<RouteItems>& lhs, const std::vector<RouteItems>& rhs) {
+	return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), IsSameItem);
+}
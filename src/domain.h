@@ -1,16 +1,72 @@
 #pragma once
 #include "geo.h"
 
+#include <cstdint>
+#include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
+// Dense ids handed out by TransportCatalogue in the order of insertion, so data about stops and buses
+// is kept in vectors indexed by them
+using StopId = uint32_t;
+using BusId = uint32_t;
+
+// The names are views of the name arena of the catalogue
 struct Stop {
-	std::string name;
+	std::string_view name;
 	geo::Coordinates coordinates;
+	StopId id = 0;
 };
 
 struct Bus {
-	std::string name;
-	std::vector<const Stop*> route;
+	std::string_view name;
+	std::vector<StopId> route;
 	bool is_roundtrip;
+	BusId id = 0;
+};
+
+struct RouteItems {
+	std::string_view type;
+	std::string_view name;
+	double time;
+	int span_count = 0;
+};
+
+// The same trip for a rider: the same steps, with the times equal up to the rounding of the sums they are made of
+bool IsSameTrip(const std::vector<RouteItems>& lhs, const std::vector<RouteItems>& rhs);
+
+enum class RouterEngine {
+	FLOYD_WARSHALL,
+	DIJKSTRA,
+	CONTRACTION_HIERARCHIES,
+	TILED_FLOYD_WARSHALL,
+	ALT,
+	RAPTOR,
+};
+
+// How the rides of the buses become edges of the routing graph
+enum class GraphModel {
+	// An edge for every pair of stops of a bus: O(n^2) edges per route, but only two vertexes per stop
+	COMPLETE,
+	// A ride vertex for every stop of a bus linked by the edges between neighbouring stops: O(n) edges per route
+	LINEAR,
+};
+
+// Weights of a named routing profile, the other settings are shared by all profiles
+struct RouteProfile {
+	int bus_wait_time = 0;
+	double bus_velocity = 0.0;
+};
+
+struct RouteSettings {
+	int bus_wait_time = 0;
+	double bus_velocity = 0.0;
+	RouterEngine engine = RouterEngine::FLOYD_WARSHALL;
+	// The linear model is only used when asked for
+	GraphModel graph_model = GraphModel::COMPLETE;
+	// Threads that build the graph and the tiled table, 0 means one per hardware core. The result does not depend on it
+	size_t thread_count = 0;
+	// Answered over the same vertexes and edges, each profile has only its own weights and engine data
+	std::map<std::string, RouteProfile> profiles;
 };
\ No newline at end of file
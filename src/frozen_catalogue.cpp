@@ -0,0 +1,284 @@
+#include "frozen_catalogue.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace transport_catalogue {
+
+namespace {
+
+size_t GetChunkCount(size_t count, size_t chunk_size) {
+    return (count + chunk_size - 1) / chunk_size;
+}
+
+// The chunks of the ids, each once and in order, and the chunks of the ids added since the previous copy
+std::vector<size_t> GetChangedChunks(const std::vector<uint32_t>& ids, size_t previous_count, size_t count, size_t chunk_size) {
+    std::vector<size_t> chunks;
+    chunks.reserve(ids.size() + 1);
+    for (const uint32_t id : ids) {
+        chunks.push_back(id / chunk_size);
+    }
+    // The last chunk of the previous copy only changes if the ids were added to it
+    if (count > previous_count) {
+        for (size_t chunk = previous_count / chunk_size; chunk < GetChunkCount(count, chunk_size); ++chunk) {
+            chunks.push_back(chunk);
+        }
+    }
+    std::sort(chunks.begin(), chunks.end());
+    chunks.erase(std::unique(chunks.begin(), chunks.end()), chunks.end());
+    return chunks;
+}
+
+}  // namespace
+
+FrozenCatalogue::FrozenCatalogue(const TransportCatalogue& catalogue)
+    : stop_count_(catalogue.GetStopCount()), bus_count_(catalogue.GetBusCount()) {
+    for (size_t chunk = 0; chunk < GetChunkCount(stop_count_, CHUNK_SIZE); ++chunk) {
+        stop_chunks_.push_back(MakeStopChunk(catalogue, chunk));
+    }
+    for (size_t chunk = 0; chunk < GetChunkCount(bus_count_, CHUNK_SIZE); ++chunk) {
+        bus_chunks_.push_back(MakeBusChunk(catalogue, chunk));
+    }
+    stop_names_ = MakeNameShards(catalogue, stop_count_, &GetStopName);
+    bus_names_ = MakeNameShards(catalogue, bus_count_, &GetBusName);
+}
+
+FrozenCatalogue::FrozenCatalogue(const TransportCatalogue& catalogue, const FrozenCatalogue& previous, const Changes& changes)
+    : stop_count_(catalogue.GetStopCount())
+    , bus_count_(catalogue.GetBusCount())
+    , stop_chunks_(previous.stop_chunks_)
+    , bus_chunks_(previous.bus_chunks_)
+    , stop_names_(previous.stop_names_)
+    , bus_names_(previous.bus_names_) {
+    stop_chunks_.resize(GetChunkCount(stop_count_, CHUNK_SIZE));
+    for (const size_t chunk : GetChangedChunks(changes.stops, previous.stop_count_, stop_count_, CHUNK_SIZE)) {
+        stop_chunks_[chunk] = MakeStopChunk(catalogue, chunk);
+    }
+    bus_chunks_.resize(GetChunkCount(bus_count_, CHUNK_SIZE));
+    for (const size_t chunk : GetChangedChunks(changes.buses, previous.bus_count_, bus_count_, CHUNK_SIZE)) {
+        bus_chunks_[chunk] = MakeBusChunk(catalogue, chunk);
+    }
+
+    // Only a new stop changes the index of the stop names; any changed bus may have been added or removed
+    std::vector<uint32_t> new_stops;
+    for (StopId id = static_cast<StopId>(previous.stop_count_); id < stop_count_; ++id) {
+        new_stops.push_back(id);
+    }
+    UpdateNameShards(catalogue, stop_names_, new_stops, &GetStopName);
+    std::vector<uint32_t> changed_buses = changes.buses;
+    for (BusId id = static_cast<BusId>(previous.bus_count_); id < bus_count_; ++id) {
+        changed_buses.push_back(id);
+    }
+    UpdateNameShards(catalogue, bus_names_, changed_buses, &GetBusName);
+}
+
+size_t FrozenCatalogue::HashName(std::string_view name) {
+    return std::hash<std::string_view>{}(name);
+}
+
+size_t FrozenCatalogue::GetShardIndex(size_t hash) {
+    return hash % NAME_SHARD_COUNT;
+}
+
+std::shared_ptr<const FrozenCatalogue::StopChunk> FrozenCatalogue::MakeStopChunk(const TransportCatalogue& catalogue, size_t chunk_index) {
+    const size_t first = chunk_index * CHUNK_SIZE;
+    const size_t last = std::min(first + CHUNK_SIZE, catalogue.GetStopCount());
+    auto chunk = std::make_shared<StopChunk>();
+    chunk->stops.reserve(last - first);
+    for (StopId id = static_cast<StopId>(first); id < last; ++id) {
+        chunk->stops.push_back(catalogue.GetStop(id));
+
+        const auto distances = catalogue.GetRoadDistances(id);
+        chunk->distances.insert(chunk->distances.end(), distances.begin(), distances.end());
+        chunk->distance_offsets.push_back(static_cast<uint32_t>(chunk->distances.size()));
+        const auto buses = catalogue.GetStopBuses(id);
+        chunk->buses.insert(chunk->buses.end(), buses.begin(), buses.end());
+        chunk->bus_offsets.push_back(static_cast<uint32_t>(chunk->buses.size()));
+    }
+    return chunk;
+}
+
+std::shared_ptr<const FrozenCatalogue::BusChunk> FrozenCatalogue::MakeBusChunk(const TransportCatalogue& catalogue, size_t chunk_index) {
+    const size_t first = chunk_index * CHUNK_SIZE;
+    const size_t last = std::min(first + CHUNK_SIZE, catalogue.GetBusCount());
+    auto chunk = std::make_shared<BusChunk>();
+
+    // The routes are copied first, the spans are taken once the array no longer grows
+    std::vector<uint32_t> route_offsets = {0};
+    for (BusId id = static_cast<BusId>(first); id < last; ++id) {
+        const auto& route = catalogue.GetBus(id).route;
+        chunk->route_stops.insert(chunk->route_stops.end(), route.begin(), route.end());
+        route_offsets.push_back(static_cast<uint32_t>(chunk->route_stops.size()));
+    }
+
+    chunk->buses.reserve(last - first);
+    chunk->infos.reserve(last - first);
+    for (BusId id = static_cast<BusId>(first); id < last; ++id) {
+        const Bus& bus = catalogue.GetBus(id);
+        const size_t i = id - first;
+        const std::span<const StopId> route(chunk->route_stops.data() + route_offsets[i], route_offsets[i + 1] - route_offsets[i]);
+        chunk->buses.push_back({ bus.name, route, bus.is_roundtrip, id });
+        // A removed bus keeps its id and its route
+        chunk->infos.push_back(catalogue.FindBus(bus.name) == &bus ? catalogue.GetBusInfo(bus.name) : BusInfo{});
+    }
+    return chunk;
+}
+
+std::pair<std::string_view, bool> FrozenCatalogue::GetStopName(const TransportCatalogue& catalogue, uint32_t id) {
+    const Stop& stop = catalogue.GetStop(id);
+    return { stop.name, catalogue.FindStop(stop.name) == &stop };
+}
+
+std::pair<std::string_view, bool> FrozenCatalogue::GetBusName(const TransportCatalogue& catalogue, uint32_t id) {
+    const Bus& bus = catalogue.GetBus(id);
+    return { bus.name, catalogue.FindBus(bus.name) == &bus };
+}
+
+std::vector<std::shared_ptr<const FrozenCatalogue::NameShard>> FrozenCatalogue::MakeNameShards(const TransportCatalogue& catalogue, size_t count,
+                                                                                               NameGetter get_name) {
+    std::vector<NameShard> shards(NAME_SHARD_COUNT);
+    for (uint32_t id = 0; id < count; ++id) {
+        if (const auto [name, is_found] = get_name(catalogue, id); is_found) {
+            const size_t hash = HashName(name);
+            shards[GetShardIndex(hash)].push_back({ hash, id });
+        }
+    }
+
+    std::vector<std::shared_ptr<const NameShard>> result;
+    result.reserve(NAME_SHARD_COUNT);
+    for (auto& shard : shards) {
+        SortNameShard(shard);
+        result.push_back(std::make_shared<const NameShard>(std::move(shard)));
+    }
+    return result;
+}
+
+void FrozenCatalogue::UpdateNameShards(const TransportCatalogue& catalogue, std::vector<std::shared_ptr<const NameShard>>& shards,
+                                       const std::vector<uint32_t>& ids, NameGetter get_name) {
+    // An entry lies in the shard of its name, so the ids are looked for only there
+    std::vector<std::vector<uint32_t>> shard_ids(NAME_SHARD_COUNT);
+    for (const uint32_t id : ids) {
+        shard_ids[GetShardIndex(HashName(get_name(catalogue, id).first))].push_back(id);
+    }
+
+    for (size_t shard_index = 0; shard_index < NAME_SHARD_COUNT; ++shard_index) {
+        auto& changed_ids = shard_ids[shard_index];
+        if (changed_ids.empty()) {
+            continue;
+        }
+        std::sort(changed_ids.begin(), changed_ids.end());
+        changed_ids.erase(std::unique(changed_ids.begin(), changed_ids.end()), changed_ids.end());
+
+        const NameShard& shard = *shards[shard_index];
+        NameShard updated;
+        updated.reserve(shard.size() + changed_ids.size());
+        for (const NameEntry& entry : shard) {
+            if (!std::binary_search(changed_ids.begin(), changed_ids.end(), entry.id)) {
+                updated.push_back(entry);
+            }
+        }
+        for (const uint32_t id : changed_ids) {
+            if (const auto [name, is_found] = get_name(catalogue, id); is_found) {
+                updated.push_back({ HashName(name), id });
+            }
+        }
+        SortNameShard(updated);
+        shards[shard_index] = std::make_shared<const NameShard>(std::move(updated));
+    }
+}
+
+void FrozenCatalogue::SortNameShard(NameShard& shard) {
+    std::sort(shard.begin(), shard.end(), [](const NameEntry& lhs, const NameEntry& rhs) { return lhs.hash < rhs.hash; });
+}
+
+std::span<const FrozenCatalogue::NameEntry> FrozenCatalogue::FindNameEntries(const std::vector<std::shared_ptr<const NameShard>>& shards,
+                                                                            std::string_view name) {
+    const size_t hash = HashName(name);
+    const NameShard& shard = *shards[GetShardIndex(hash)];
+    const auto [first, last] = std::equal_range(shard.begin(), shard.end(), NameEntry{ hash, 0 },
+                                                [](const NameEntry& lhs, const NameEntry& rhs) { return lhs.hash < rhs.hash; });
+    return { first, last };
+}
+
+const FrozenCatalogue::StopChunk& FrozenCatalogue::GetStopChunk(StopId id) const {
+    return *stop_chunks_[id / CHUNK_SIZE];
+}
+
+const FrozenCatalogue::BusChunk& FrozenCatalogue::GetBusChunk(BusId id) const {
+    return *bus_chunks_[id / CHUNK_SIZE];
+}
+
+const Stop* FrozenCatalogue::FindStop(std::string_view name) const {
+    for (const NameEntry& entry : FindNameEntries(stop_names_, name)) {
+        const Stop& stop = GetStopChunk(entry.id).stops[entry.id % CHUNK_SIZE];
+        if (stop.name == name) {
+            return &stop;
+        }
+    }
+    return nullptr;
+}
+
+const FrozenBus* FrozenCatalogue::FindBus(std::string_view name) const {
+    for (const NameEntry& entry : FindNameEntries(bus_names_, name)) {
+        const FrozenBus& bus = GetBusChunk(entry.id).buses[entry.id % CHUNK_SIZE];
+        if (bus.name == name) {
+            return &bus;
+        }
+    }
+    return nullptr;
+}
+
+BusInfo FrozenCatalogue::GetBusInfo(std::string_view name) const {
+    const FrozenBus* bus = FindBus(name);
+    if (bus == nullptr) {
+        return {};
+    }
+    return GetBusChunk(bus->id).infos[bus->id % CHUNK_SIZE];
+}
+
+std::span<const BusId> FrozenCatalogue::GetStopInfo(std::string_view name) const {
+    const Stop* stop = FindStop(name);
+    if (stop == nullptr) {
+        return {};
+    }
+    const StopChunk& chunk = GetStopChunk(stop->id);
+    const size_t i = stop->id % CHUNK_SIZE;
+    return { chunk.buses.data() + chunk.bus_offsets[i], chunk.bus_offsets[i + 1] - chunk.bus_offsets[i] };
+}
+
+int FrozenCatalogue::GetDistance(StopId stop_from, StopId stop_to) const {
+    const StopChunk& chunk = GetStopChunk(stop_from);
+    const size_t i = stop_from % CHUNK_SIZE;
+    const auto first = chunk.distances.begin() + chunk.distance_offsets[i];
+    const auto last = chunk.distances.begin() + chunk.distance_offsets[i + 1];
+    const auto it = std::lower_bound(first, last, stop_to, [](const RoadDistance& lhs, StopId rhs) { return lhs.to < rhs; });
+    if (it == last || it->to != stop_to) {
+        return geo::ComputeDistance(GetStop(stop_from).coordinates, GetStop(stop_to).coordinates);
+    }
+    return it->distance;
+}
+
+const Stop& FrozenCatalogue::GetStop(StopId id) const {
+    if (id >= stop_count_) {
+        throw std::out_of_range("Unknown stop id");
+    }
+    return GetStopChunk(id).stops[id % CHUNK_SIZE];
+}
+
+const FrozenBus& FrozenCatalogue::GetBus(BusId id) const {
+    if (id >= bus_count_) {
+        throw std::out_of_range("Unknown bus id");
+    }
+    return GetBusChunk(id).buses[id % CHUNK_SIZE];
+}
+
+size_t FrozenCatalogue::GetStopCount() const {
+    return stop_count_;
+}
+
+size_t FrozenCatalogue::GetBusCount() const {
+    return bus_count_;
+}
+
+}  // namespace transport_catalogue
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+
+// A bus of the frozen catalogue; the route is a slice of one array shared by the buses of its chunk
+struct FrozenBus {
+    std::string_view name;
+    std::span<const StopId> route;
+    bool is_roundtrip = false;
+    BusId id = 0;
+};
+
+// Read-only copy of a loaded catalogue in flat arrays. The stops and the buses go in chunks of CHUNK_SIZE ids;
+// the road distances and the buses of the stops of a chunk, and the routes of its buses, are each one array
+// sliced by offsets. The names are not copied, they are the views of the catalogue and stay valid as long as
+// it lives; the copy has only its own index of them, split into shards by hash. Nothing changes after the
+// constructor, so every lookup is const, allocates nothing and may run on any number of threads at once
+// without locks. The ids are those of the catalogue it was built from.
+// The chunks and the shards are shared between the copies, so the copy of a changed catalogue builds only
+// the ones the change touched and takes the rest over from the previous copy
+class FrozenCatalogue {
+public:
+    // What a change of the catalogue touched, in any order and with repeats
+    struct Changes {
+        // Stops added, or with new road distances or buses
+        std::vector<StopId> stops;
+        // Buses added or removed, or with new stats
+        std::vector<BusId> buses;
+    };
+
+    explicit FrozenCatalogue(const TransportCatalogue& catalogue);
+    // The copy of the catalogue after the changes, sharing the rest with the copy made before them
+    FrozenCatalogue(const TransportCatalogue& catalogue, const FrozenCatalogue& previous, const Changes& changes);
+
+    const Stop* FindStop(std::string_view name) const;
+    // nullptr for an unknown or removed bus
+    const FrozenBus* FindBus(std::string_view name) const;
+    BusInfo GetBusInfo(std::string_view name) const;
+    // Buses passing the stop in the order of their names, empty for an unknown stop
+    std::span<const BusId> GetStopInfo(std::string_view name) const;
+    int GetDistance(StopId stop_from, StopId stop_to) const;
+
+    // Throw std::out_of_range for an unknown id
+    const Stop& GetStop(StopId id) const;
+    const FrozenBus& GetBus(BusId id) const;
+    size_t GetStopCount() const;
+    size_t GetBusCount() const;
+
+private:
+    static constexpr size_t CHUNK_SIZE = 64;
+    static constexpr size_t NAME_SHARD_COUNT = 256;
+
+    // A stop or a bus of the index by name, the name itself is the one of the chunk
+    struct NameEntry {
+        size_t hash = 0;
+        uint32_t id = 0;
+    };
+    // Sorted by hash
+    using NameShard = std::vector<NameEntry>;
+
+    struct StopChunk {
+        std::vector<Stop> stops;
+        // The road distances from the i-th stop of the chunk are distances[distance_offsets[i] .. distance_offsets[i + 1]),
+        // sorted by RoadDistance::to
+        std::vector<uint32_t> distance_offsets = {0};
+        std::vector<RoadDistance> distances;
+        // The same for the buses of the stops, sorted by name
+        std::vector<uint32_t> bus_offsets = {0};
+        std::vector<BusId> buses;
+    };
+
+    struct BusChunk {
+        std::vector<FrozenBus> buses;
+        // Empty stats for a removed bus
+        std::vector<BusInfo> infos;
+        std::vector<StopId> route_stops;
+    };
+
+    static size_t HashName(std::string_view name);
+    static size_t GetShardIndex(size_t hash);
+    static std::shared_ptr<const StopChunk> MakeStopChunk(const TransportCatalogue& catalogue, size_t chunk_index);
+    static std::shared_ptr<const BusChunk> MakeBusChunk(const TransportCatalogue& catalogue, size_t chunk_index);
+
+    // The name of the stop (bus) and whether the catalogue finds it by the name: it does not find a removed bus,
+    // nor a stop added again under its name
+    using NameGetter = std::pair<std::string_view, bool> (*)(const TransportCatalogue& catalogue, uint32_t id);
+    static std::pair<std::string_view, bool> GetStopName(const TransportCatalogue& catalogue, uint32_t id);
+    static std::pair<std::string_view, bool> GetBusName(const TransportCatalogue& catalogue, uint32_t id);
+    // The shards of the ids from 0 to count
+    static std::vector<std::shared_ptr<const NameShard>> MakeNameShards(const TransportCatalogue& catalogue, size_t count, NameGetter get_name);
+    // Only the shards of the ids are copied: their entries are dropped and added again if the catalogue finds them
+    static void UpdateNameShards(const TransportCatalogue& catalogue, std::vector<std::shared_ptr<const NameShard>>& shards,
+                                 const std::vector<uint32_t>& ids, NameGetter get_name);
+    static void SortNameShard(NameShard& shard);
+
+    // The entries with the hash of the name, the caller compares the names
+    static std::span<const NameEntry> FindNameEntries(const std::vector<std::shared_ptr<const NameShard>>& shards, std::string_view name);
+    const StopChunk& GetStopChunk(StopId id) const;
+    const BusChunk& GetBusChunk(BusId id) const;
+
+    size_t stop_count_ = 0;
+    size_t bus_count_ = 0;
+    std::vector<std::shared_ptr<const StopChunk>> stop_chunks_;
+    std::vector<std::shared_ptr<const BusChunk>> bus_chunks_;
+    std::vector<std::shared_ptr<const NameShard>> stop_names_;
+    // Only the buses that are not removed
+    std::vector<std::shared_ptr<const NameShard>> bus_names_;
+};
+
+}  // namespace transport_catalogue
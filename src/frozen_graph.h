@@ -0,0 +1,204 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+
+namespace graph {
+
+// Read-only copy of a DirectedWeightedGraph in compressed sparse row form. The arcs leaving a vertex lie
+// in a row, and their heads, weights and edge ids are kept in separate arrays, so a relaxation loop reads
+// contiguous memory and never touches the names of the edges. Removed edges are not copied.
+// The arcs are shared by the reweighted copies, only the weights are their own
+template <typename Weight>
+class FrozenGraph {
+public:
+    // Position of an arc in the arrays, the arcs leaving vertex v are [offsets[v], offsets[v + 1])
+    using ArcId = uint32_t;
+    using ArcRange = std::ranges::iota_view<ArcId, ArcId>;
+
+    FrozenGraph();
+    // The arcs of every vertex keep the order of its incidence list
+    explicit FrozenGraph(const DirectedWeightedGraph<Weight>& graph);
+
+    // The same arcs turned backwards, with the same weights and edge ids
+    FrozenGraph Transpose() const;
+    // The same arcs weighted by get_weight(edge_id), without copying them
+    template <typename WeightFunc>
+    FrozenGraph Reweight(WeightFunc get_weight) const;
+    // Changes the weight of the arc of a frozen edge in place; the copies sharing the arcs keep their weights.
+    // Throws std::out_of_range for an edge that was removed or added after freezing
+    void SetEdgeWeight(EdgeId edge_id, Weight weight);
+
+    size_t GetVertexCount() const;
+    size_t GetArcCount() const;
+    ArcRange GetArcs(VertexId vertex) const;
+    VertexId GetSource(ArcId arc) const;
+    VertexId GetTarget(ArcId arc) const;
+    Weight GetWeight(ArcId arc) const;
+    // Id of the edge in the graph the arc was frozen from, the edge keeps the rest of its data
+    EdgeId GetEdgeId(ArcId arc) const;
+
+private:
+    static constexpr size_t MAX_INDEX = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t NO_ARC = std::numeric_limits<uint32_t>::max();
+
+    struct Topology {
+        std::vector<uint32_t> offsets = {0};
+        std::vector<uint32_t> targets;
+        std::vector<uint32_t> edge_ids;
+        // The arc by edge id, NO_ARC for a removed edge
+        std::vector<uint32_t> arcs_by_edge;
+    };
+
+    void SetTopology(std::shared_ptr<const Topology> topology);
+
+    std::shared_ptr<const Topology> topology_;
+    // Views of the shared arrays, so the searches do not go through topology_ for every arc
+    const uint32_t* offsets_ = nullptr;
+    const uint32_t* targets_ = nullptr;
+    const uint32_t* edge_ids_ = nullptr;
+    size_t vertex_count_ = 0;
+    std::vector<Weight> weights_;
+};
+
+template <typename Weight>
+FrozenGraph<Weight>::FrozenGraph() {
+    SetTopology(std::make_shared<Topology>());
+}
+
+template <typename Weight>
+void FrozenGraph<Weight>::SetTopology(std::shared_ptr<const Topology> topology) {
+    topology_ = std::move(topology);
+    offsets_ = topology_->offsets.data();
+    targets_ = topology_->targets.data();
+    edge_ids_ = topology_->edge_ids.data();
+    vertex_count_ = topology_->offsets.size() - 1;
+}
+
+template <typename Weight>
+FrozenGraph<Weight>::FrozenGraph(const DirectedWeightedGraph<Weight>& graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+    if (vertex_count >= MAX_INDEX || graph.GetEdgeCount() >= MAX_INDEX) {
+        throw std::length_error("Too many vertexes or edges for a 32-bit frozen graph");
+    }
+
+    auto topology = std::make_shared<Topology>();
+    topology->offsets.reserve(vertex_count + 1);
+    topology->targets.reserve(graph.GetEdgeCount());
+    topology->edge_ids.reserve(graph.GetEdgeCount());
+    topology->arcs_by_edge.assign(graph.GetEdgeCount(), NO_ARC);
+    weights_.reserve(graph.GetEdgeCount());
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto& edge = graph.GetEdge(edge_id);
+            topology->arcs_by_edge[edge_id] = static_cast<uint32_t>(topology->targets.size());
+            topology->targets.push_back(static_cast<uint32_t>(edge.to));
+            topology->edge_ids.push_back(static_cast<uint32_t>(edge_id));
+            weights_.push_back(edge.weight);
+        }
+        topology->offsets.push_back(static_cast<uint32_t>(topology->targets.size()));
+    }
+    SetTopology(std::move(topology));
+}
+
+template <typename Weight>
+FrozenGraph<Weight> FrozenGraph<Weight>::Transpose() const {
+    // Counting sort by the head of the arc, the arcs entering a vertex stay in the order of their sources
+    const size_t vertex_count = GetVertexCount();
+    const auto& targets = topology_->targets;
+    auto reversed = std::make_shared<Topology>();
+    reversed->offsets.assign(vertex_count + 1, 0);
+    for (const uint32_t target : targets) {
+        ++reversed->offsets[target + 1];
+    }
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        reversed->offsets[vertex + 1] += reversed->offsets[vertex];
+    }
+
+    FrozenGraph transposed;
+    reversed->targets.resize(targets.size());
+    reversed->edge_ids.resize(targets.size());
+    reversed->arcs_by_edge.assign(topology_->arcs_by_edge.size(), NO_ARC);
+    transposed.weights_.resize(weights_.size());
+    std::vector<uint32_t> next_arcs(reversed->offsets.begin(), reversed->offsets.end() - 1);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (const ArcId arc : GetArcs(vertex)) {
+            const uint32_t reversed_arc = next_arcs[targets[arc]]++;
+            reversed->targets[reversed_arc] = static_cast<uint32_t>(vertex);
+            reversed->edge_ids[reversed_arc] = topology_->edge_ids[arc];
+            reversed->arcs_by_edge[topology_->edge_ids[arc]] = reversed_arc;
+            transposed.weights_[reversed_arc] = weights_[arc];
+        }
+    }
+    transposed.SetTopology(std::move(reversed));
+    return transposed;
+}
+
+template <typename Weight>
+template <typename WeightFunc>
+FrozenGraph<Weight> FrozenGraph<Weight>::Reweight(WeightFunc get_weight) const {
+    FrozenGraph reweighted;
+    reweighted.SetTopology(topology_);
+    reweighted.weights_.reserve(weights_.size());
+    for (const uint32_t edge_id : topology_->edge_ids) {
+        reweighted.weights_.push_back(get_weight(static_cast<EdgeId>(edge_id)));
+    }
+    return reweighted;
+}
+
+template <typename Weight>
+void FrozenGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+    const auto& arcs_by_edge = topology_->arcs_by_edge;
+    if (edge_id >= arcs_by_edge.size() || arcs_by_edge[edge_id] == NO_ARC) {
+        throw std::out_of_range("Edge is not in the frozen graph");
+    }
+    weights_[arcs_by_edge[edge_id]] = weight;
+}
+
+template <typename Weight>
+size_t FrozenGraph<Weight>::GetVertexCount() const {
+    return vertex_count_;
+}
+
+template <typename Weight>
+size_t FrozenGraph<Weight>::GetArcCount() const {
+    return topology_->targets.size();
+}
+
+template <typename Weight>
+typename FrozenGraph<Weight>::ArcRange FrozenGraph<Weight>::GetArcs(VertexId vertex) const {
+    if (vertex >= vertex_count_) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+    return ArcRange(offsets_[vertex], offsets_[vertex + 1]);
+}
+
+template <typename Weight>
+VertexId FrozenGraph<Weight>::GetSource(ArcId arc) const {
+    // Only routes are unpacked this way, so the arrays keep no source of their own
+    return std::upper_bound(offsets_, offsets_ + vertex_count_ + 1, arc) - offsets_ - 1;
+}
+
+template <typename Weight>
+VertexId FrozenGraph<Weight>::GetTarget(ArcId arc) const {
+    return targets_[arc];
+}
+
+template <typename Weight>
+Weight FrozenGraph<Weight>::GetWeight(ArcId arc) const {
+    return weights_[arc];
+}
+
+template <typename Weight>
+EdgeId FrozenGraph<Weight>::GetEdgeId(ArcId arc) const {
+    return edge_ids_[arc];
+}
+
+}  // namespace graph
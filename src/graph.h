@@ -2,20 +2,27 @@
 
 #include "ranges.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
 #include <vector>
 
 namespace graph {
 
 using VertexId = size_t;
 using EdgeId = size_t;
+// Compact id of a bus, the owner of the graph resolves it
+using BusId = uint32_t;
+
+inline constexpr BusId NO_BUS = std::numeric_limits<BusId>::max();
 
 template <typename Weight>
 struct Edge {
     VertexId from;
     VertexId to;
     Weight weight;
-    std::string name;
+    BusId bus_id = NO_BUS;
     int span_count = 0;
 };
 
@@ -28,7 +35,15 @@ private:
 public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
+    VertexId AddVertex();
     EdgeId AddEdge(const Edge<Weight>& edge);
+    // Gives the edges the same ids as AddEdge one by one, but counts them by the tail vertex first,
+    // so every incidence list grows once
+    template <typename EdgeRange>
+    void AddEdges(const EdgeRange& edges);
+    void SetEdgeWeight(EdgeId edge_id, Weight weight);
+    // The edge keeps its id, so the routers' tables stay valid, but it is no longer incident to any vertex
+    void RemoveEdge(EdgeId edge_id);
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
@@ -45,6 +60,12 @@ DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
     : incidence_lists_(vertex_count) {
 }
 
+template <typename Weight>
+VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+    incidence_lists_.emplace_back();
+    return incidence_lists_.size() - 1;
+}
+
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
     edges_.push_back(edge);
@@ -53,6 +74,40 @@ EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
     return id;
 }
 
+template <typename Weight>
+template <typename EdgeRange>
+void DirectedWeightedGraph<Weight>::AddEdges(const EdgeRange& edges) {
+    std::vector<size_t> tail_counts(incidence_lists_.size(), 0);
+    size_t edge_count = 0;
+    for (const Edge<Weight>& edge : edges) {
+        ++tail_counts.at(edge.from);
+        ++edge_count;
+    }
+
+    edges_.reserve(edges_.size() + edge_count);
+    for (VertexId vertex = 0; vertex < incidence_lists_.size(); ++vertex) {
+        incidence_lists_[vertex].reserve(incidence_lists_[vertex].size() + tail_counts[vertex]);
+    }
+    for (const Edge<Weight>& edge : edges) {
+        incidence_lists_[edge.from].push_back(edges_.size());
+        edges_.push_back(edge);
+    }
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+    edges_.at(edge_id).weight = weight;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::RemoveEdge(EdgeId edge_id) {
+    auto& incidence_list = incidence_lists_.at(edges_.at(edge_id).from);
+    const auto it = std::find(incidence_list.begin(), incidence_list.end(), edge_id);
+    if (it != incidence_list.end()) {
+        incidence_list.erase(it);
+    }
+}
+
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
     return incidence_lists_.size();
@@ -1,7 +1,9 @@
 #include "json_reader.h"
 
 #include <algorithm>
+#include <functional>
 #include <sstream>
+#include <unordered_set>
 
 JsonReader::JsonReader(std::istream& input) {
     json::Document input_data = json::Load(input);
@@ -9,18 +11,23 @@ JsonReader::JsonReader(std::istream& input) {
     stat_request_ = input_data.GetRoot().AsMap().at("stat_requests");
     render_settings_ = input_data.GetRoot().AsMap().at("render_settings");
     route_settings_ = input_data.GetRoot().AsMap().at("routing_settings");
+
+    const auto& root = input_data.GetRoot().AsMap();
+    if (auto it = root.find("serialization_settings"); it != root.end()) {
+        snapshot_path_ = it->second.AsMap().at("file").AsString();
+    }
 }
 
 void JsonReader::ParseStopsInCatalogue(transport_catalogue::TransportCatalogue& catalogue) {
 
     for (const auto& request : base_request_.AsArray()) {
-        std::string name;
+        std::string_view name;
         geo::Coordinates coordinates;
 
         for (const auto& [request_name, value] : request.AsMap()) {
             if (request_name == "type") {
                 if (value.AsString() != "Stop") {
-                    name.clear();
+                    name = {};
                     break;
                 }
             }
@@ -43,13 +50,13 @@ void JsonReader::ParseStopsInCatalogue(transport_catalogue::TransportCatalogue&
 void JsonReader::ParseStopDistanceInCatalogue(transport_catalogue::TransportCatalogue& catalogue) {
 
     for (const auto& request : base_request_.AsArray()) {
-        std::string name;
+        std::string_view name;
         std::map<std::string_view, int> road_distances;
 
         for (const auto& [request_name, value] : request.AsMap()) {
             if (request_name == "type") {
                 if (value.AsString() != "Stop") {
-                    name.clear();
+                    name = {};
                     break;
                 }
             }
@@ -66,7 +73,7 @@ void JsonReader::ParseStopDistanceInCatalogue(transport_catalogue::TransportCata
             auto stop_from = catalogue.FindStop(name);
             for (const auto& [stop, distance] : road_distances) {
                 auto stop_to = catalogue.FindStop(stop);
-                catalogue.SetDistance(stop_from, stop_to, distance);
+                catalogue.SetDistance(stop_from->id, stop_to->id, distance);
             }
         }
     }
@@ -75,14 +82,14 @@ void JsonReader::ParseStopDistanceInCatalogue(transport_catalogue::TransportCata
 void JsonReader::ParseBusInCatalogue(transport_catalogue::TransportCatalogue& catalogue) {
 
     for (const auto& request : base_request_.AsArray()) {
-        std::string name;
+        std::string_view name;
         bool is_roundtrip = false;
         std::vector<std::string_view> stops;
 
         for (const auto& [request_name, value] : request.AsMap()) {
             if (request_name == "type") {
                 if (value.AsString() != "Bus") {
-                    name.clear();
+                    name = {};
                     break;
                 }
             }
@@ -98,35 +105,57 @@ void JsonReader::ParseBusInCatalogue(transport_catalogue::TransportCatalogue& ca
                 }
             }
         }
-        if (!name.empty()) {
-
-            RouteInfoBegEnd info;
-            info.begin_route = *stops.begin();
-            info.end_route = stops.back();
+        // The first bus of a name is the one kept, as it always was
+        if (!name.empty() && catalogue.FindBus(name) == nullptr) {
+            catalogue.AddBus(name, MakeRoundRoute(stops, is_roundtrip), is_roundtrip);
+            routes_[catalogue.FindBus(name)->name] = { stops.front(), stops.back() };
+        }
+    }
+}
 
-            if (*stops.begin() == stops.back() && is_roundtrip) {
-                catalogue.AddBus(name, stops, is_roundtrip);
-                routes_[name] = { stops, info };
-                continue;
-            }
+std::vector<std::string_view> JsonReader::MakeRoundRoute(const std::vector<std::string_view>& stops, bool is_roundtrip) {
+    std::vector<std::string_view> round_route(stops.begin(), stops.end());
+    if (!is_roundtrip) {
+        for (auto it = ++stops.rbegin(); it != stops.rend(); ++it) {
+            round_route.push_back(*it);
+        }
+    }
+    else if (stops.front() != stops.back()) {
+        round_route.push_back(stops.front());
+    }
+    return round_route;
+}
 
-            std::vector<std::string_view> round_route(stops.begin(), stops.end());
+RouterEngine JsonReader::ParseRouterEngine(const std::string& name) {
+    if (name == "floyd_warshall") {
+        return RouterEngine::FLOYD_WARSHALL;
+    }
+    else if (name == "dijkstra") {
+        return RouterEngine::DIJKSTRA;
+    }
+    else if (name == "contraction_hierarchies") {
+        return RouterEngine::CONTRACTION_HIERARCHIES;
+    }
+    else if (name == "tiled_floyd_warshall") {
+        return RouterEngine::TILED_FLOYD_WARSHALL;
+    }
+    else if (name == "alt") {
+        return RouterEngine::ALT;
+    }
+    else if (name == "raptor") {
+        return RouterEngine::RAPTOR;
+    }
+    throw std::invalid_argument("Unknown router engine: " + name);
+}
 
-            if (!is_roundtrip) {
-                for (auto it = ++stops.rbegin(); it != stops.rend(); ++it) {
-                    round_route.push_back(*it);
-                }
-                catalogue.AddBus(name, round_route, is_roundtrip);
-                routes_[name] = { round_route, info };
-            }
-            else {
-                auto it = stops.begin();
-                round_route.push_back(*it);
-                catalogue.AddBus(name, round_route, is_roundtrip);
-                routes_[name] = { round_route, info };
-            }
-        }
+GraphModel JsonReader::ParseGraphModel(const std::string& name) {
+    if (name == "complete") {
+        return GraphModel::COMPLETE;
+    }
+    else if (name == "linear") {
+        return GraphModel::LINEAR;
     }
+    throw std::invalid_argument("Unknown graph model: " + name);
 }
 
 RouteSettings JsonReader::ParseRouteSettings() {
@@ -138,12 +167,37 @@ RouteSettings JsonReader::ParseRouteSettings() {
         else if (setting_name == "bus_velocity") {
             settings.bus_velocity = value.AsDouble();
         }
+        else if (setting_name == "router_engine") {
+            settings.engine = ParseRouterEngine(value.AsString());
+        }
+        else if (setting_name == "graph_model") {
+            settings.graph_model = ParseGraphModel(value.AsString());
+        }
+        else if (setting_name == "thread_count") {
+            settings.thread_count = static_cast<size_t>(value.AsInt());
+        }
+    }
+
+    // A profile takes what it does not set from the settings themselves
+    if (const auto it = route_settings_.AsMap().find("profiles"); it != route_settings_.AsMap().end()) {
+        for (const auto& [profile_name, profile_settings] : it->second.AsMap()) {
+            RouteProfile profile{ settings.bus_wait_time, settings.bus_velocity };
+            for (const auto& [setting_name, value] : profile_settings.AsMap()) {
+                if (setting_name == "bus_wait_time") {
+                    profile.bus_wait_time = value.AsInt();
+                }
+                else if (setting_name == "bus_velocity") {
+                    profile.bus_velocity = value.AsDouble();
+                }
+            }
+            settings.profiles[profile_name] = profile;
+        }
     }
     return settings;
 }
 
-void JsonReader::GetResultOfBus(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer, std::string name) {
-    const auto& result = catalogue.GetBusInfo(name);
+void JsonReader::GetResultOfBus(json::Builder& answer, std::string name) {
+    const auto result = versioned_catalogue_->Pin()->GetBusInfo(name);
 
     if (result.stops == 0) {
         std::string str = "not found";
@@ -161,8 +215,9 @@ void JsonReader::GetResultOfBus(transport_catalogue::TransportCatalogue& catalog
     result_.push_back(answer.Build());
 }
 
-void JsonReader::GetResultOfStop(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer, std::string name) {
-    const auto ptr = catalogue.FindStop(name);
+void JsonReader::GetResultOfStop(json::Builder& answer, std::string name) {
+    const auto catalogue = versioned_catalogue_->Pin();
+    const auto ptr = catalogue->FindStop(name);
 
     if (ptr == nullptr) {
         std::string str = "not found";
@@ -171,14 +226,10 @@ void JsonReader::GetResultOfStop(transport_catalogue::TransportCatalogue& catalo
         return;
     }
 
-    const auto& result = catalogue.GetStopInfo(name);
-    std::vector<std::string_view> vec_result(result.begin(), result.end());
-    std::sort(vec_result.begin(), vec_result.end());
-
     answer.Key("buses").StartArray();
 
-    for (const auto& bus : vec_result) {
-        answer.Value(std::string(bus));
+    for (const BusId bus : catalogue->GetStopInfo(name)) {
+        answer.Value(std::string(catalogue->GetBus(bus).name));
     }
     answer.EndArray().EndDict();
     result_.push_back(answer.Build());
@@ -191,17 +242,37 @@ void JsonReader::GetResultOfMap(transport_catalogue::TransportCatalogue& catalog
     result_.push_back(answer.Build());
 }
 
-void JsonReader::GetResultOfRoute(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer, std::string stop_from, std::string stop_to) {
-    if (catalogue.GetStopInfo(stop_from).size() == 0 || catalogue.GetStopInfo(stop_to).size() == 0) {
+void JsonReader::GetResultOfRoute(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer, std::string stop_from, std::string stop_to, int alternatives, const std::string& profile) {
+    if (!HasBuses(stop_from) || !HasBuses(stop_to) || !GetRouter(catalogue).HasProfile(profile)) {
         answer.Key("error_message").Value("not found").EndDict();
         result_.push_back(answer.Build());
         return;
     }
 
-    static TransportRouter router(catalogue, ParseRouteSettings());
-    router_ = &router;
-    auto items = router_->FindRoute(stop_from, stop_to);
-    double route_time = 0.0;
+    if (alternatives > 0) {
+        const auto routes = GetRouter(catalogue).FindAlternativeRoutes(stop_from, stop_to, alternatives, profile);
+        if (routes.empty()) {
+            answer.Key("error_message").Value("not found").EndDict();
+            result_.push_back(answer.Build());
+            return;
+        }
+
+        // The fastest route is answered as usual, all of them are listed in "alternatives"
+        answer.Key("items");
+        double route_time = AddRouteItems(answer, routes.front());
+        answer.Key("total_time").Value(route_time);
+        answer.Key("alternatives").StartArray();
+        for (const auto& items : routes) {
+            answer.StartDict().Key("items");
+            double alternative_time = AddRouteItems(answer, items);
+            answer.Key("total_time").Value(alternative_time).EndDict();
+        }
+        answer.EndArray().EndDict();
+        result_.push_back(answer.Build());
+        return;
+    }
+
+    auto items = GetRouter(catalogue).FindRoute(stop_from, stop_to, profile);
 
     if (items.size() == 1 && items[0].type == "error_message") {
         answer.Key("error_message").Value("not found").EndDict();
@@ -209,26 +280,316 @@ void JsonReader::GetResultOfRoute(transport_catalogue::TransportCatalogue& catal
         return;
     }
 
-    answer.Key("items").StartArray();
+    answer.Key("items");
+    double route_time = AddRouteItems(answer, items);
+    answer.Key("total_time").Value(route_time).EndDict();
+    result_.push_back(answer.Build());
+}
+
+void JsonReader::GetResultOfRouteMatrix(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer, const std::vector<std::string>& stops_from, const std::vector<std::string>& stops_to, bool with_items, const std::string& profile) {
+    if (!GetRouter(catalogue).HasProfile(profile)) {
+        answer.Key("error_message").Value("not found").EndDict();
+        result_.push_back(answer.Build());
+        return;
+    }
+
+    const auto routes = GetRouter(catalogue).FindRoutes(stops_from, stops_to, profile);
+
+    answer.Key("total_times").StartArray();
+    for (const auto& row : routes) {
+        answer.StartArray();
+        for (const auto& items : row) {
+            if (!items.has_value()) {
+                answer.Value(nullptr);
+                continue;
+            }
+            double route_time = 0.0;
+            for (const auto& item : *items) {
+                route_time += item.time;
+            }
+            answer.Value(route_time);
+        }
+        answer.EndArray();
+    }
+    answer.EndArray();
+
+    if (with_items) {
+        answer.Key("items").StartArray();
+        for (const auto& row : routes) {
+            answer.StartArray();
+            for (const auto& items : row) {
+                if (items.has_value()) {
+                    AddRouteItems(answer, *items);
+                }
+                else {
+                    answer.Value(nullptr);
+                }
+            }
+            answer.EndArray();
+        }
+        answer.EndArray();
+    }
+    answer.EndDict();
+    result_.push_back(answer.Build());
+}
+
+double JsonReader::AddRouteItems(json::Builder& answer, const std::vector<RouteItems>& items) {
+    double route_time = 0.0;
+
+    answer.StartArray();
     for (const auto& item : items) {
         route_time += item.time;
         answer.StartDict().Key("type").Value(item.type.data()).Key("time").Value(item.time);
         if (item.type == "Bus") {
-            answer.Key("bus").Value(item.name.data()).Key("span_count").Value(item.span_count);
+            answer.Key("bus").Value(std::string(item.name)).Key("span_count").Value(item.span_count);
         }
         else if (item.type == "Wait") {
-            answer.Key("stop_name").Value(item.name.data());
+            answer.Key("stop_name").Value(std::string(item.name));
         }
         answer.EndDict();
     }
-    answer.EndArray().Key("total_time").Value(route_time).EndDict();
+    answer.EndArray();
+    return route_time;
+}
+
+void JsonReader::GetResultOfParetoRoute(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer, const std::string& stop_from, const std::string& stop_to, const std::string& profile) {
+    if (!HasBuses(stop_from) || !HasBuses(stop_to) || !GetRouter(catalogue).HasProfile(profile)) {
+        answer.Key("error_message").Value("not found").EndDict();
+        result_.push_back(answer.Build());
+        return;
+    }
+
+    const auto routes = GetRouter(catalogue).FindParetoRoutes(stop_from, stop_to, profile);
+    if (routes.empty()) {
+        answer.Key("error_message").Value("not found").EndDict();
+        result_.push_back(answer.Build());
+        return;
+    }
+
+    answer.Key("routes").StartArray();
+    for (const auto& items : routes) {
+        const auto bus_count = std::count_if(items.begin(), items.end(), [](const RouteItems& item) { return item.type == "Bus"; });
+        answer.StartDict().Key("bus_count").Value(static_cast<int>(bus_count)).Key("items");
+        double route_time = AddRouteItems(answer, items);
+        answer.Key("total_time").Value(route_time).EndDict();
+    }
+    answer.EndArray().EndDict();
+    result_.push_back(answer.Build());
+}
+
+void JsonReader::GetResultOfReachable(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer, const std::string& stop_from, double max_time, const std::string& profile) {
+    if (!HasBuses(stop_from) || !GetRouter(catalogue).HasProfile(profile)) {
+        answer.Key("error_message").Value("not found").EndDict();
+        result_.push_back(answer.Build());
+        return;
+    }
+
+    answer.Key("stops").StartArray();
+    for (const auto& stop : GetRouter(catalogue).FindReachableStops(stop_from, max_time, profile)) {
+        answer.StartDict().Key("stop_name").Value(std::string(stop.name)).Key("time").Value(stop.time).EndDict();
+    }
+    answer.EndArray().EndDict();
+    result_.push_back(answer.Build());
+}
+
+void JsonReader::GetResultOfRouterStats(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer) {
+    const auto stats = GetRouter(catalogue).GetStats();
+    answer.Key("vertex_count").Value(static_cast<int>(stats.vertex_count));
+    answer.Key("edge_count").Value(static_cast<int>(stats.edge_count));
+    answer.Key("router_memory_kb").Value(static_cast<int>(stats.router_memory / 1024));
+    answer.EndDict();
+    result_.push_back(answer.Build());
+}
+
+void JsonReader::GetResultOfUpdate(json::Builder& answer, const json::Array& requests) {
+    struct StopEdit {
+        std::string_view name;
+        geo::Coordinates coordinates;
+        std::map<std::string_view, int> road_distances;
+    };
+    // A Bus or a RemoveBus, kept in the order of the request
+    struct BusEdit {
+        std::string_view name;
+        std::vector<std::string_view> stops;
+        bool is_roundtrip = false;
+        bool is_removal = false;
+    };
+    std::vector<StopEdit> stop_edits;
+    std::vector<BusEdit> bus_edits;
+
+    // Nothing is changed unless the whole request is valid
+    bool is_valid = true;
+    for (const auto& request : requests) {
+        const auto& request_map = request.AsMap();
+        const std::string& type = request_map.at("type").AsString();
+        const std::string_view name = request_map.at("name").AsString();
+        if (type == "Stop") {
+            StopEdit edit{ name, { request_map.at("latitude").AsDouble(), request_map.at("longitude").AsDouble() }, {} };
+            if (const auto it = request_map.find("road_distances"); it != request_map.end()) {
+                for (const auto& [stop, distance] : it->second.AsMap()) {
+                    edit.road_distances.insert({ stop, distance.AsInt() });
+                }
+            }
+            stop_edits.push_back(std::move(edit));
+        }
+        else if (type == "Bus") {
+            BusEdit edit{ name, {}, request_map.at("is_roundtrip").AsBool(), false };
+            for (const auto& stop : request_map.at("stops").AsArray()) {
+                edit.stops.push_back(stop.AsString());
+            }
+            is_valid = is_valid && !edit.stops.empty();
+            bus_edits.push_back(std::move(edit));
+        }
+        else if (type == "RemoveBus") {
+            bus_edits.push_back({ name, {}, false, true });
+        }
+        else {
+            is_valid = false;
+        }
+    }
+
+    // Like the base requests, the stops of the request may be named anywhere in it
+    {
+        const auto catalogue = versioned_catalogue_->Pin();
+        std::unordered_set<std::string_view> new_stops;
+        for (const auto& edit : stop_edits) {
+            new_stops.insert(edit.name);
+        }
+        const auto is_known = [&](std::string_view stop) { return new_stops.count(stop) > 0 || catalogue->FindStop(stop) != nullptr; };
+        for (const auto& edit : stop_edits) {
+            for (const auto& [stop, distance] : edit.road_distances) {
+                is_valid = is_valid && is_known(stop);
+            }
+        }
+        for (const auto& edit : bus_edits) {
+            is_valid = is_valid && std::all_of(edit.stops.begin(), edit.stops.end(), is_known);
+        }
+    }
+    if (!is_valid) {
+        answer.Key("error_message").Value("invalid update").EndDict();
+        result_.push_back(answer.Build());
+        return;
+    }
+
+    // The router reads the catalogue itself, so its build has to be over before the catalogue changes
+    if (router_future_.valid()) {
+        router_ = router_future_.get();
+    }
+
+    std::vector<std::pair<const Stop*, const Stop*>> changed_distances;
+    // The buses the router knows that are gone, and the new buses still there after the whole request
+    std::vector<const Bus*> removed_buses;
+    std::vector<std::pair<const Bus*, RouteInfoBegEnd>> added_buses;
+    versioned_catalogue_->Update([&](transport_catalogue::VersionedCatalogue::Editor& editor) {
+        const auto& edited = editor.GetCatalogue();
+        // A known stop keeps its place and only gets the new distances
+        for (const auto& edit : stop_edits) {
+            if (edited.FindStop(edit.name) == nullptr) {
+                editor.AddStop(edit.name, edit.coordinates);
+            }
+        }
+        for (const auto& edit : stop_edits) {
+            const Stop* stop_from = edited.FindStop(edit.name);
+            for (const auto& [stop, distance] : edit.road_distances) {
+                const Stop* stop_to = edited.FindStop(stop);
+                editor.SetDistance(stop_from->id, stop_to->id, distance);
+                changed_distances.push_back({ stop_from, stop_to });
+            }
+        }
+        // A bus with a known name replaces it
+        for (const auto& edit : bus_edits) {
+            if (const Bus* bus = edited.FindBus(edit.name)) {
+                editor.RemoveBus(edit.name);
+                const auto added = std::find_if(added_buses.begin(), added_buses.end(), [bus](const auto& item) { return item.first == bus; });
+                if (added != added_buses.end()) {
+                    added_buses.erase(added);
+                }
+                else {
+                    removed_buses.push_back(bus);
+                }
+            }
+            if (!edit.is_removal) {
+                editor.AddBus(edit.name, MakeRoundRoute(edit.stops, edit.is_roundtrip), edit.is_roundtrip);
+                added_buses.push_back({ edited.FindBus(edit.name), { edit.stops.front(), edit.stops.back() } });
+            }
+        }
+    });
+
+    if (router_) {
+        TransportRouter::Changes changes{ std::move(changed_distances), removed_buses, {} };
+        for (const auto& [bus, info] : added_buses) {
+            changes.added_buses.push_back(bus);
+        }
+        router_->Update(changes);
+    }
+
+    // The map is drawn from routes_ again by the next Map request
+    for (const Bus* bus : removed_buses) {
+        routes_.erase(bus->name);
+    }
+    for (const auto& [bus, info] : added_buses) {
+        routes_[bus->name] = info;
+    }
+    routes_for_paint_.ClearRoutes();
+
+    answer.EndDict();
     result_.push_back(answer.Build());
 }
 
+bool JsonReader::HasBuses(std::string_view stop) const {
+    return !versioned_catalogue_->Pin()->GetStopInfo(stop).empty();
+}
+
+bool JsonReader::NeedsRouter() const {
+    static const std::unordered_set<std::string_view> router_types = {"Route", "RouteMatrix", "ParetoRoute", "Reachable", "RouterStats"};
+    for (const auto& request : stat_request_.AsArray()) {
+        const auto& request_map = request.AsMap();
+        if (auto it = request_map.find("type"); it != request_map.end() && router_types.count(it->second.AsString()) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void JsonReader::StartRouterBuild(const transport_catalogue::TransportCatalogue& catalogue) {
+    // Settings are parsed here, so a bad one is reported by this thread
+    router_future_ = std::async(std::launch::async, &JsonReader::BuildRouter, std::cref(catalogue), ParseRouteSettings(), snapshot_path_);
+}
+
+std::unique_ptr<TransportRouter> JsonReader::BuildRouter(const transport_catalogue::TransportCatalogue& catalogue, RouteSettings settings,
+                                                         std::filesystem::path snapshot_path) {
+    std::unique_ptr<TransportRouter> router;
+    if (!snapshot_path.empty()) {
+        router = TransportRouter::FromSnapshot(catalogue, settings, snapshot_path);
+    }
+    if (!router) {
+        router = std::make_unique<TransportRouter>(catalogue, settings);
+        // A missing or stale snapshot is replaced; the engines whose data it does not keep leave it alone
+        if (!snapshot_path.empty() && TransportRouter::IsSnapshotEngine(settings.engine)) {
+            router->SaveSnapshot(snapshot_path);
+        }
+    }
+    return router;
+}
+
+const TransportRouter& JsonReader::GetRouter(transport_catalogue::TransportCatalogue& catalogue) {
+    if (!router_) {
+        if (!router_future_.valid()) {
+            StartRouterBuild(catalogue);
+        }
+        // Rethrows whatever the build has thrown
+        router_ = router_future_.get();
+    }
+    return *router_;
+}
+
 void JsonReader::GetResult(transport_catalogue::TransportCatalogue& catalogue) {
     for (const auto& request : stat_request_.AsArray()) {
-        std::string name, type, stop_from, stop_to;
-        int id = 0;
+        std::string name, type, stop_from, stop_to, profile;
+        std::vector<std::string> stops_from, stops_to;
+        bool with_items = false;
+        int id = 0, alternatives = 0;
+        double max_time = 0.0;
         json::Builder answer;
 
         for (const auto& [request_name, value] : request.AsMap()) {
@@ -247,21 +608,58 @@ void JsonReader::GetResult(transport_catalogue::TransportCatalogue& catalogue) {
             else if (request_name == "to") {
                 stop_to = value.AsString();
             }
+            else if (request_name == "sources") {
+                for (const auto& stop : value.AsArray()) {
+                    stops_from.push_back(stop.AsString());
+                }
+            }
+            else if (request_name == "targets") {
+                for (const auto& stop : value.AsArray()) {
+                    stops_to.push_back(stop.AsString());
+                }
+            }
+            else if (request_name == "with_items") {
+                with_items = value.AsBool();
+            }
+            else if (request_name == "alternatives") {
+                alternatives = value.AsInt();
+            }
+            else if (request_name == "max_time") {
+                max_time = value.AsDouble();
+            }
+            else if (request_name == "profile") {
+                profile = value.AsString();
+            }
         }
 
         answer.StartDict().Key("request_id").Value(id);
 
         if (type == "Bus") {
-            GetResultOfBus(catalogue, answer, name);
+            GetResultOfBus(answer, name);
         }
         else if (type == "Stop") {
-            GetResultOfStop(catalogue, answer, name);
+            GetResultOfStop(answer, name);
         }
         else if (type == "Map") {
             GetResultOfMap(catalogue, answer);
         }
         else if (type == "Route") {
-            GetResultOfRoute(catalogue, answer, stop_from, stop_to);
+            GetResultOfRoute(catalogue, answer, stop_from, stop_to, alternatives, profile);
+        }
+        else if (type == "RouteMatrix") {
+            GetResultOfRouteMatrix(catalogue, answer, stops_from, stops_to, with_items, profile);
+        }
+        else if (type == "ParetoRoute") {
+            GetResultOfParetoRoute(catalogue, answer, stop_from, stop_to, profile);
+        }
+        else if (type == "Reachable") {
+            GetResultOfReachable(catalogue, answer, stop_from, max_time, profile);
+        }
+        else if (type == "RouterStats") {
+            GetResultOfRouterStats(catalogue, answer);
+        }
+        else if (type == "Update") {
+            GetResultOfUpdate(answer, request.AsMap().at("base_requests").AsArray());
         }
     }
 }
@@ -272,7 +670,13 @@ void JsonReader::ParseData(transport_catalogue::TransportCatalogue& catalogue) {
     ParseStopsInCatalogue(catalogue);
     ParseStopDistanceInCatalogue(catalogue);
     ParseBusInCatalogue(catalogue);
+    catalogue.Finalize();
+    versioned_catalogue_ = std::make_unique<transport_catalogue::VersionedCatalogue>(catalogue);
     ParseRenderSettings();
+    // Bus, Stop and Map requests only read the catalogue, so they are answered while the router is built
+    if (NeedsRouter()) {
+        StartRouterBuild(catalogue);
+    }
     GetResult(catalogue);
 }
 
@@ -288,13 +692,13 @@ void JsonReader::ParseDataForPaint(transport_catalogue::TransportCatalogue& cata
     for (const auto& [name, route] : routes_) {
         RouteInfo info;
 
-        for (const auto& stop : route.first) {
-            auto st = catalogue.FindStop(stop);
+        for (const StopId stop : catalogue.FindBus(name)->route) {
+            auto st = &catalogue.GetStop(stop);
             routes_points.push_back(st);
-            if (st->name == route.second.begin_route && info.beg_end_.empty()) {
+            if (st->name == route.begin_route && info.beg_end_.empty()) {
                 info.beg_end_.push_back(st);
             }
-            if (st->name == route.second.end_route && st->name != route.second.begin_route && info.beg_end_.size() == 1) {
+            if (st->name == route.end_route && st->name != route.begin_route && info.beg_end_.size() == 1) {
                 info.beg_end_.push_back(st);
             }
         }
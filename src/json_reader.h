@@ -5,6 +5,9 @@
 #include "router.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
+#include "versioned_catalogue.h"
+
+#include <future>
 
 class JsonReader {
 public:
@@ -19,13 +22,35 @@ private:
     void ParseStopsInCatalogue(transport_catalogue::TransportCatalogue& catalogue);
     void ParseStopDistanceInCatalogue(transport_catalogue::TransportCatalogue& catalogue);
     void ParseBusInCatalogue(transport_catalogue::TransportCatalogue& catalogue);
+    // The route as the catalogue keeps it: there and back for a bus that is not a roundtrip, closed for one that is
+    static std::vector<std::string_view> MakeRoundRoute(const std::vector<std::string_view>& stops, bool is_roundtrip);
     void ParseDataForPaint(transport_catalogue::TransportCatalogue& catalogue);
     void ParseRenderSettings();
-    void GetResultOfBus(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer, std::string name);
-    void GetResultOfStop(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer, std::string name);
+    void GetResultOfBus(json::Builder& answer, std::string name);
+    void GetResultOfStop(json::Builder& answer, std::string name);
     void GetResultOfMap(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer);
+    RouterEngine ParseRouterEngine(const std::string& name);
+    GraphModel ParseGraphModel(const std::string& name);
     RouteSettings ParseRouteSettings();
-    void GetResultOfRoute(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer, std::string stop_from, std::string stop_to);
+    void GetResultOfRoute(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer, std::string stop_from, std::string stop_to, int alternatives, const std::string& profile);
+    void GetResultOfRouteMatrix(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer, const std::vector<std::string>& stops_from, const std::vector<std::string>& stops_to, bool with_items, const std::string& profile);
+    double AddRouteItems(json::Builder& answer, const std::vector<RouteItems>& items);
+    void GetResultOfParetoRoute(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer, const std::string& stop_from, const std::string& stop_to, const std::string& profile);
+    void GetResultOfReachable(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer, const std::string& stop_from, double max_time, const std::string& profile);
+    void GetResultOfRouterStats(transport_catalogue::TransportCatalogue& catalogue, json::Builder& answer);
+    // Stops, distances, buses and RemoveBus requests published as one version of the catalogue; the router,
+    // if there is one, is patched after them
+    void GetResultOfUpdate(json::Builder& answer, const json::Array& requests);
+    // True if some bus passes the stop, as the router needs
+    bool HasBuses(std::string_view stop) const;
+    // True if some stat request is answered by the router
+    bool NeedsRouter() const;
+    // The catalogue must not change until the router is taken by GetRouter
+    void StartRouterBuild(const transport_catalogue::TransportCatalogue& catalogue);
+    static std::unique_ptr<TransportRouter> BuildRouter(const transport_catalogue::TransportCatalogue& catalogue, RouteSettings settings,
+                                                        std::filesystem::path snapshot_path);
+    // Waits for the build started by StartRouterBuild, or starts it if there is none
+    const TransportRouter& GetRouter(transport_catalogue::TransportCatalogue& catalogue);
 
 private:
     json::Node base_request_;
@@ -33,7 +58,15 @@ private:
     json::Node render_settings_;
     json::Node route_settings_;
     json::Array result_;
-    std::map<std::string, std::pair<std::vector<std::string_view>, RouteInfoBegEnd>> routes_;
+    // Keyed by the names kept in the catalogue; the stops are taken from it by id when the map is drawn
+    std::map<std::string_view, RouteInfoBegEnd> routes_;
     PaintDataRoutes routes_for_paint_;
-    TransportRouter* router_;
+    // Published once the catalogue is loaded. Every Bus and Stop answer and every check of the route stops pins
+    // the current version, so they need no lock whatever thread answers them and whatever is published meanwhile
+    std::unique_ptr<transport_catalogue::VersionedCatalogue> versioned_catalogue_;
+    std::unique_ptr<TransportRouter> router_;
+    // Built on another thread while the requests before the first route are answered
+    std::future<std::unique_ptr<TransportRouter>> router_future_;
+    // Router snapshot from "serialization_settings", empty if there is none
+    std::filesystem::path snapshot_path_;
 };
\ No newline at end of file
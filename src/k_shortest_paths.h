@@ -0,0 +1,247 @@
+#pragma once
+
+#include "frozen_graph.h"
+#include "router_base.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Yen's algorithm for the k shortest loopless routes to one target. A single backward Dijkstra gives
+// the exact weight of the rest of the route from every vertex. Banning edges and vertices can only make
+// routes longer, so it stays a consistent A* heuristic and every spur search heads straight to the target
+template <typename Weight>
+class KShortestPaths {
+private:
+    using Graph = FrozenGraph<Weight>;
+    using ArcId = typename Graph::ArcId;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    KShortestPaths(const Graph& graph, VertexId to);
+
+    // Up to count routes from the vertex in the order of weight, the first one is the shortest
+    std::vector<RouteInfo> BuildRoutes(VertexId from, size_t count);
+    // The same, but only the routes accept(route) is true for are returned and counted. The rejected ones
+    // still lead the search to the next routes
+    template <typename AcceptFunc>
+    std::vector<RouteInfo> BuildRoutes(VertexId from, size_t count, AcceptFunc accept);
+
+private:
+    // Routes are searched as arcs of the frozen graph and turned into edges at the end
+    struct ArcRoute {
+        Weight weight;
+        std::vector<ArcId> arcs;
+    };
+
+    // A* search that avoids the banned arcs and vertices
+    std::optional<ArcRoute> BuildSpurRoute(VertexId from);
+
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight UNREACHED = std::numeric_limits<Weight>::max();
+
+    const Graph& graph_;
+    VertexId to_;
+    std::vector<Weight> rest_weights_;
+    // Scratch buffers of the spur searches, only the touched vertices are reset
+    std::vector<Weight> weights_;
+    std::vector<std::optional<ArcId>> prev_arcs_;
+    std::vector<VertexId> touched_vertexes_;
+    std::vector<bool> banned_vertexes_;
+    std::vector<bool> banned_arcs_;
+};
+
+template <typename Weight>
+KShortestPaths<Weight>::KShortestPaths(const Graph& graph, VertexId to)
+    : graph_(graph)
+    , to_(to)
+    , rest_weights_(graph.GetVertexCount(), UNREACHED)
+    , weights_(graph.GetVertexCount(), UNREACHED)
+    , prev_arcs_(graph.GetVertexCount())
+    , banned_vertexes_(graph.GetVertexCount(), false)
+    , banned_arcs_(graph.GetArcCount(), false)
+{
+    if (to >= graph.GetVertexCount()) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+    for (ArcId arc = 0; arc < graph.GetArcCount(); ++arc) {
+        if (graph.GetWeight(arc) < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    const Graph transposed_graph = graph.Transpose();
+
+    Queue queue;
+    rest_weights_[to] = ZERO_WEIGHT;
+    queue.push({ZERO_WEIGHT, to});
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (rest_weights_[vertex] < weight) {
+            continue;
+        }
+        for (const ArcId arc : transposed_graph.GetArcs(vertex)) {
+            const VertexId prev = transposed_graph.GetTarget(arc);
+            const Weight candidate_weight = weight + transposed_graph.GetWeight(arc);
+            if (candidate_weight < rest_weights_[prev]) {
+                rest_weights_[prev] = candidate_weight;
+                queue.push({candidate_weight, prev});
+            }
+        }
+    }
+}
+
+template <typename Weight>
+std::vector<typename KShortestPaths<Weight>::RouteInfo> KShortestPaths<Weight>::BuildRoutes(VertexId from, size_t count) {
+    return BuildRoutes(from, count, [](const RouteInfo&) { return true; });
+}
+
+template <typename Weight>
+template <typename AcceptFunc>
+std::vector<typename KShortestPaths<Weight>::RouteInfo> KShortestPaths<Weight>::BuildRoutes(VertexId from, size_t count, AcceptFunc accept) {
+    if (from >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+    std::vector<RouteInfo> result;
+    if (count == 0 || rest_weights_[from] == UNREACHED) {
+        return result;
+    }
+    const auto add_result = [&](const ArcRoute& route) {
+        std::vector<EdgeId> edges;
+        edges.reserve(route.arcs.size());
+        for (const ArcId arc : route.arcs) {
+            edges.push_back(graph_.GetEdgeId(arc));
+        }
+        RouteInfo info{route.weight, std::move(edges)};
+        if (accept(info)) {
+            result.push_back(std::move(info));
+        }
+    };
+
+    std::vector<ArcRoute> routes;
+    routes.push_back(*BuildSpurRoute(from));
+    add_result(routes.back());
+
+    // Ties are broken by the arc ids, so the order does not depend on when a candidate was found
+    std::set<std::pair<Weight, std::vector<ArcId>>> candidates;
+    // A path found again from another spur may sum its weight in another order and differ by rounding,
+    // so the paths are told apart by the arcs alone
+    std::set<std::vector<ArcId>> found_arcs = {routes.back().arcs};
+
+    while (result.size() < count) {
+        const std::vector<ArcId> last_arcs = routes.back().arcs;
+        VertexId spur_vertex = from;
+        Weight root_weight = ZERO_WEIGHT;
+
+        for (size_t spur_index = 0; spur_index < last_arcs.size(); ++spur_index) {
+            // Routes found with the same root may not continue the same way again
+            const auto for_each_next_arc = [&](auto action) {
+                for (const auto& route : routes) {
+                    if (route.arcs.size() > spur_index
+                        && std::equal(route.arcs.begin(), route.arcs.begin() + spur_index, last_arcs.begin())) {
+                        action(route.arcs[spur_index]);
+                    }
+                }
+            };
+            for_each_next_arc([this](ArcId arc) { banned_arcs_[arc] = true; });
+            const auto spur_route = BuildSpurRoute(spur_vertex);
+            for_each_next_arc([this](ArcId arc) { banned_arcs_[arc] = false; });
+
+            if (spur_route) {
+                std::vector<ArcId> arcs(last_arcs.begin(), last_arcs.begin() + spur_index);
+                arcs.insert(arcs.end(), spur_route->arcs.begin(), spur_route->arcs.end());
+                if (found_arcs.insert(arcs).second) {
+                    candidates.emplace(root_weight + spur_route->weight, std::move(arcs));
+                }
+            }
+
+            // The root is never visited twice, that keeps the routes loopless
+            banned_vertexes_[spur_vertex] = true;
+            root_weight += graph_.GetWeight(last_arcs[spur_index]);
+            spur_vertex = graph_.GetTarget(last_arcs[spur_index]);
+        }
+
+        banned_vertexes_[from] = false;
+        for (const ArcId arc : last_arcs) {
+            banned_vertexes_[graph_.GetTarget(arc)] = false;
+        }
+
+        if (candidates.empty()) {
+            break;
+        }
+        auto candidate = candidates.extract(candidates.begin());
+        routes.push_back(ArcRoute{candidate.value().first, std::move(candidate.value().second)});
+        add_result(routes.back());
+    }
+    return result;
+}
+
+template <typename Weight>
+std::optional<typename KShortestPaths<Weight>::ArcRoute> KShortestPaths<Weight>::BuildSpurRoute(VertexId from) {
+    for (const VertexId vertex : touched_vertexes_) {
+        weights_[vertex] = UNREACHED;
+        prev_arcs_[vertex].reset();
+    }
+    touched_vertexes_.clear();
+
+    Queue queue;
+    weights_[from] = ZERO_WEIGHT;
+    touched_vertexes_.push_back(from);
+    queue.push({rest_weights_[from], from});
+
+    while (!queue.empty()) {
+        const auto [key, vertex] = queue.top();
+        queue.pop();
+        const Weight weight = weights_[vertex];
+        if (weight + rest_weights_[vertex] < key) {
+            continue;
+        }
+        if (vertex == to_) {
+            break;
+        }
+        for (const ArcId arc : graph_.GetArcs(vertex)) {
+            const VertexId next = graph_.GetTarget(arc);
+            if (banned_arcs_[arc] || banned_vertexes_[next] || rest_weights_[next] == UNREACHED) {
+                continue;
+            }
+            const Weight candidate_weight = weight + graph_.GetWeight(arc);
+            if (candidate_weight < weights_[next]) {
+                if (weights_[next] == UNREACHED) {
+                    touched_vertexes_.push_back(next);
+                }
+                weights_[next] = candidate_weight;
+                prev_arcs_[next] = arc;
+                queue.push({candidate_weight + rest_weights_[next], next});
+            }
+        }
+    }
+
+    if (weights_[to_] == UNREACHED) {
+        return std::nullopt;
+    }
+
+    std::vector<ArcId> arcs;
+    for (std::optional<ArcId> arc = prev_arcs_[to_];
+         arc;
+         arc = prev_arcs_[graph_.GetSource(*arc)])
+    {
+        arcs.push_back(*arc);
+    }
+    std::reverse(arcs.begin(), arcs.end());
+
+    return ArcRoute{weights_[to_], std::move(arcs)};
+}
+
+}  // namespace graph
@@ -15,6 +15,10 @@ void PaintDataRoutes::AddRoute(std::string_view name, RouteInfo info) {
     routes_.insert({ name, info });
 }
 
+void PaintDataRoutes::ClearRoutes() {
+    routes_.clear();
+}
+
 void PaintDataRoutes::RenderData(std::ostream& out) {
     std::vector<geo::Coordinates> routes;
 
@@ -114,6 +114,7 @@ struct RouteInfo {
 class PaintDataRoutes {
 public:
     void AddRoute(std::string_view, RouteInfo info);
+    void ClearRoutes();
     void RenderData(std::ostream& out);
     void SetRenderSetting(const RenderSettings& settings);
 private:
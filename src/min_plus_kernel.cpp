@@ -0,0 +1,81 @@
+#include "min_plus_kernel.h"
+
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define TRANSPORT_CATALOGUE_HAS_AVX2_KERNEL
+#include <immintrin.h>
+#endif
+
+namespace graph {
+
+namespace {
+
+using RelaxRowFunc = void (*)(StoredWeight weight_from, const StoredWeight* weights_through, const StoredEdgeId* prev_edges_through,
+                              StoredWeight* weights_from, StoredEdgeId* prev_edges_from, size_t size);
+
+// Branchless min-plus step, left to the compiler to vectorize for the target of the build
+void RelaxRowPortable(StoredWeight weight_from, const StoredWeight* weights_through, const StoredEdgeId* prev_edges_through,
+                      StoredWeight* weights_from, StoredEdgeId* prev_edges_from, size_t size) {
+    for (size_t column = 0; column < size; ++column) {
+        const StoredWeight weight = weights_from[column];
+        const StoredEdgeId prev_edge = prev_edges_from[column];
+        const StoredWeight candidate_weight = weight_from + weights_through[column];
+        const auto is_shorter_mask = StoredEdgeId{0} - static_cast<StoredEdgeId>(candidate_weight < weight);
+        weights_from[column] = std::min(weight, candidate_weight);
+        prev_edges_from[column] = prev_edge ^ ((prev_edge ^ prev_edges_through[column]) & is_shorter_mask);
+    }
+}
+
+#ifdef TRANSPORT_CATALOGUE_HAS_AVX2_KERNEL
+// Eight cells at a time: the compare mask picks both the shorter weight and the last edge of its route.
+// The edge ids are moved as floats, blending only copies their bits
+__attribute__((target("avx2"))) void RelaxRowAvx2(StoredWeight weight_from, const StoredWeight* weights_through,
+                                                  const StoredEdgeId* prev_edges_through, StoredWeight* weights_from,
+                                                  StoredEdgeId* prev_edges_from, size_t size) {
+    const __m256 weight_from_vector = _mm256_set1_ps(weight_from);
+    for (size_t column = 0; column < size; column += 8) {
+        const __m256 weight = _mm256_loadu_ps(weights_from + column);
+        const __m256 candidate_weight = _mm256_add_ps(weight_from_vector, _mm256_loadu_ps(weights_through + column));
+        const __m256 is_shorter = _mm256_cmp_ps(candidate_weight, weight, _CMP_LT_OQ);
+        _mm256_storeu_ps(weights_from + column, _mm256_blendv_ps(weight, candidate_weight, is_shorter));
+
+        auto* prev_edge_cells = reinterpret_cast<float*>(prev_edges_from + column);
+        const auto* prev_edge_through_cells = reinterpret_cast<const float*>(prev_edges_through + column);
+        const __m256 prev_edge = _mm256_loadu_ps(prev_edge_cells);
+        _mm256_storeu_ps(prev_edge_cells, _mm256_blendv_ps(prev_edge, _mm256_loadu_ps(prev_edge_through_cells), is_shorter));
+    }
+}
+#endif
+
+RelaxRowFunc SelectRelaxRow() {
+#ifdef TRANSPORT_CATALOGUE_HAS_AVX2_KERNEL
+    if (__builtin_cpu_supports("avx2")) {
+        return &RelaxRowAvx2;
+    }
+#endif
+    return &RelaxRowPortable;
+}
+
+}  // namespace
+
+void RelaxMinPlusTile(StoredWeight* weights, StoredEdgeId* prev_edges, size_t stride, size_t row_begin, size_t column_begin,
+                      size_t through_begin, size_t tile_size) {
+    static const RelaxRowFunc relax_row = SelectRelaxRow();
+
+    for (size_t vertex_through = through_begin; vertex_through < through_begin + tile_size; ++vertex_through) {
+        const StoredWeight* weights_through = weights + vertex_through * stride + column_begin;
+        const StoredEdgeId* prev_edges_through = prev_edges + vertex_through * stride + column_begin;
+
+        for (size_t vertex_from = row_begin; vertex_from < row_begin + tile_size; ++vertex_from) {
+            const StoredWeight weight_from = weights[vertex_from * stride + vertex_through];
+            if (weight_from == NO_STORED_ROUTE) {
+                continue;
+            }
+            relax_row(weight_from, weights_through, prev_edges_through, weights + vertex_from * stride + column_begin,
+                      prev_edges + vertex_from * stride + column_begin, tile_size);
+        }
+    }
+}
+
+}  // namespace graph
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "router_base.h"
+
+#include <cstddef>
+
+namespace graph {
+
+// One Floyd-Warshall step over a square tile of a flat route table with rows of stride cells: every route of the
+// tile rows to the tile columns is relaxed through each vertex of the through tile. tile_size is a multiple of 8.
+// The vector kernel is picked once by the instruction set of the running processor: AVX2 where there is one,
+// whatever the build flags, and the portable loop otherwise
+void RelaxMinPlusTile(StoredWeight* weights, StoredEdgeId* prev_edges, size_t stride, size_t row_begin, size_t column_begin,
+                      size_t through_begin, size_t tile_size);
+
+}  // namespace graph
@@ -0,0 +1,83 @@
+#include "name_arena.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace transport_catalogue {
+
+NameArena::NameId NameArena::Intern(std::string_view name) {
+    if ((names_.size() + 1) * 2 > slots_.size()) {
+        Grow();
+    }
+    const size_t slot = FindSlot(name);
+    if (slots_[slot] != NO_NAME) {
+        return slots_[slot];
+    }
+    if (names_.size() >= NO_NAME) {
+        throw std::length_error("Too many names for 32-bit ids");
+    }
+    slots_[slot] = static_cast<NameId>(names_.size());
+    names_.push_back(Append(name));
+    return slots_[slot];
+}
+
+std::optional<NameArena::NameId> NameArena::Find(std::string_view name) const {
+    if (slots_.empty()) {
+        return std::nullopt;
+    }
+    const NameId id = slots_[FindSlot(name)];
+    if (id == NO_NAME) {
+        return std::nullopt;
+    }
+    return id;
+}
+
+std::string_view NameArena::GetName(NameId id) const {
+    return names_.at(id);
+}
+
+size_t NameArena::GetNameCount() const {
+    return names_.size();
+}
+
+size_t NameArena::FindSlot(std::string_view name) const {
+    // The slot count is a power of two
+    const size_t mask = slots_.size() - 1;
+    size_t slot = std::hash<std::string_view>{}(name) & mask;
+    while (slots_[slot] != NO_NAME && names_[slots_[slot]] != name) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void NameArena::Grow() {
+    slots_.assign(std::max<size_t>(slots_.size() * 2, 16), NO_NAME);
+    for (NameId id = 0; id < names_.size(); ++id) {
+        slots_[FindSlot(names_[id])] = id;
+    }
+}
+
+std::string_view NameArena::Append(std::string_view name) {
+    if (name.empty()) {
+        return {};
+    }
+    if (name.size() > free_size_) {
+        // A long name gets a block of its own, so the tail of the current block is not thrown away
+        if (name.size() > BLOCK_SIZE / 4) {
+            blocks_.push_back(std::make_unique_for_overwrite<char[]>(name.size()));
+            std::copy(name.begin(), name.end(), blocks_.back().get());
+            return { blocks_.back().get(), name.size() };
+        }
+        blocks_.push_back(std::make_unique_for_overwrite<char[]>(BLOCK_SIZE));
+        free_ = blocks_.back().get();
+        free_size_ = BLOCK_SIZE;
+    }
+    std::copy(name.begin(), name.end(), free_);
+    const std::string_view stored(free_, name.size());
+    free_ += name.size();
+    free_size_ -= name.size();
+    return stored;
+}
+
+}  // namespace transport_catalogue
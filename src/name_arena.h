@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+
+// Append-only storage of the names of stops and buses. Every distinct name is stored once, in large blocks
+// instead of a heap allocation per name, and gets a dense id. The views handed out stay valid as long as the arena lives
+class NameArena {
+public:
+    using NameId = uint32_t;
+
+    NameArena() = default;
+    NameArena(const NameArena&) = delete;
+    NameArena& operator=(const NameArena&) = delete;
+
+    // The id of the stored copy of the name, the same for equal names
+    NameId Intern(std::string_view name);
+    std::optional<NameId> Find(std::string_view name) const;
+    std::string_view GetName(NameId id) const;
+    // Ids run from 0 to the count
+    size_t GetNameCount() const;
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    static constexpr NameId NO_NAME = std::numeric_limits<NameId>::max();
+
+    // The slot holding the name, or the empty slot where it goes
+    size_t FindSlot(std::string_view name) const;
+    std::string_view Append(std::string_view name);
+    void Grow();
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    // The unused tail of the last block
+    char* free_ = nullptr;
+    size_t free_size_ = 0;
+    std::vector<std::string_view> names_;
+    // Open addressing with linear probing: NameIds or NO_NAME, never more than half full
+    std::vector<NameId> slots_;
+};
+
+}  // namespace transport_catalogue
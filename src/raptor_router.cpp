@@ -0,0 +1,302 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <numeric>
+
+RaptorRouter::RaptorRouter(const transport_catalogue::TransportCatalogue& catalogue)
+    : catalogue_(catalogue), stop_indexes_(catalogue.GetStopCount(), NO_STOP), first_patterns_(catalogue.GetBusCount(), NO_PATTERN) {
+    // Patterns are numbered in the order of bus names, so equal routes are always resolved the same way
+    std::vector<const Bus*> buses = catalogue_.GetBuses();
+    std::sort(buses.begin(), buses.end(), [](const Bus* lhs, const Bus* rhs) { return lhs->name < rhs->name; });
+
+    for (const Bus* bus : buses) {
+        first_patterns_[bus->id] = static_cast<PatternIndex>(patterns_.size());
+        if (bus->is_roundtrip) {
+            AddPattern(bus, bus->route.size(), false);
+        }
+        else {
+            // The route of a non-roundtrip bus is stored there and back
+            const size_t size = (bus->route.size() + 1) / 2;
+            AddPattern(bus, size, false);
+            AddPattern(bus, size, true);
+        }
+    }
+    AddStopVisits();
+}
+
+void RaptorRouter::AddPattern(const Bus* bus, size_t size, bool is_backward) {
+    const auto& stops = bus->route;
+    patterns_.push_back({ bus, static_cast<uint32_t>(pattern_stops_.size()), static_cast<uint32_t>(size) });
+
+    for (size_t i = 0; i < size; ++i) {
+        const StopId stop = stops[is_backward ? size - 1 - i : i];
+        if (stop_indexes_[stop] == NO_STOP) {
+            stop_indexes_[stop] = static_cast<StopIndex>(stops_.size());
+            stops_.push_back(stop);
+        }
+        pattern_stops_.push_back(stop_indexes_[stop]);
+    }
+    pattern_distances_.resize(pattern_stops_.size());
+    SetPatternDistances(patterns_.back());
+}
+
+void RaptorRouter::SetPatternDistances(const Pattern& pattern) {
+    double distance = 0.0;
+    pattern_distances_[pattern.first] = distance;
+    for (uint32_t i = pattern.first + 1; i < pattern.first + pattern.size; ++i) {
+        distance += static_cast<double>(catalogue_.GetDistance(stops_[pattern_stops_[i - 1]], stops_[pattern_stops_[i]]));
+        pattern_distances_[i] = distance;
+    }
+}
+
+void RaptorRouter::UpdateDistances(const std::vector<BusId>& buses) {
+    for (const BusId bus : buses) {
+        if (bus >= first_patterns_.size() || first_patterns_[bus] == NO_PATTERN) {
+            continue;
+        }
+        const PatternIndex first = first_patterns_[bus];
+        const PatternIndex end = patterns_[first].bus->is_roundtrip ? first + 1 : first + 2;
+        for (PatternIndex pattern = first; pattern < end; ++pattern) {
+            SetPatternDistances(patterns_[pattern]);
+        }
+    }
+}
+
+void RaptorRouter::AddStopVisits() {
+    stop_visit_offsets_.assign(stops_.size() + 1, 0);
+    for (const StopIndex stop : pattern_stops_) {
+        ++stop_visit_offsets_[stop + 1];
+    }
+    std::partial_sum(stop_visit_offsets_.begin(), stop_visit_offsets_.end(), stop_visit_offsets_.begin());
+
+    std::vector<uint32_t> next_visits(stop_visit_offsets_.begin(), stop_visit_offsets_.end() - 1);
+    stop_visits_.resize(pattern_stops_.size());
+    for (PatternIndex pattern = 0; pattern < patterns_.size(); ++pattern) {
+        for (uint32_t position = 0; position < patterns_[pattern].size; ++position) {
+            const StopIndex stop = pattern_stops_[patterns_[pattern].first + position];
+            stop_visits_[next_visits[stop]++] = { pattern, position };
+        }
+    }
+}
+
+std::optional<RaptorRouter::StopIndex> RaptorRouter::GetStopIndex(const Stop* stop) const {
+    if (stop == nullptr || stop->id >= stop_indexes_.size() || stop_indexes_[stop->id] == NO_STOP) {
+        return std::nullopt;
+    }
+    return stop_indexes_[stop->id];
+}
+
+std::optional<std::vector<RouteItems>> RaptorRouter::FindRoute(const Stop* from, const Stop* to, const RouteSettings& settings) const {
+    const auto source = GetStopIndex(from);
+    const auto target = GetStopIndex(to);
+    if (!source || !target) {
+        return std::nullopt;
+    }
+    Search& search = GetPooledSearch();
+    RunSearch(search, settings, *source, target);
+    return ExtractRoute(search, settings, *target);
+}
+
+std::vector<std::optional<std::vector<RouteItems>>> RaptorRouter::FindRoutes(const Stop* from, const std::vector<const Stop*>& to,
+                                                                             const RouteSettings& settings) const {
+    std::vector<std::optional<std::vector<RouteItems>>> routes(to.size());
+    const auto source = GetStopIndex(from);
+    if (!source) {
+        return routes;
+    }
+
+    Search& search = GetPooledSearch();
+    RunSearch(search, settings, *source, std::nullopt);
+    for (size_t i = 0; i < to.size(); ++i) {
+        if (const auto target = GetStopIndex(to[i])) {
+            routes[i] = ExtractRoute(search, settings, *target);
+        }
+    }
+    return routes;
+}
+
+std::vector<std::pair<const Stop*, double>> RaptorRouter::FindReachableStops(const Stop* from, double max_time,
+                                                                             const RouteSettings& settings) const {
+    std::vector<std::pair<const Stop*, double>> reached;
+    const auto source = GetStopIndex(from);
+    if (!source || max_time < 0.0) {
+        return reached;
+    }
+
+    Search& search = GetPooledSearch();
+    RunSearch(search, settings, *source, std::nullopt, max_time);
+    const double* arrivals = search.arrivals.data() + (search.round_count - 1) * stops_.size();
+    for (StopIndex stop = 0; stop < stops_.size(); ++stop) {
+        if (arrivals[stop] != UNREACHED) {
+            reached.push_back({ &catalogue_.GetStop(stops_[stop]), arrivals[stop] });
+        }
+    }
+    return reached;
+}
+
+std::vector<std::vector<RouteItems>> RaptorRouter::FindParetoRoutes(const Stop* from, const Stop* to, const RouteSettings& settings) const {
+    std::vector<std::vector<RouteItems>> routes;
+    const auto source = GetStopIndex(from);
+    const auto target = GetStopIndex(to);
+    if (!source || !target) {
+        return routes;
+    }
+
+    // Pruning by the best time at the target keeps the set: a later and slower route is dominated anyway
+    Search& search = GetPooledSearch();
+    RunSearch(search, settings, *source, target);
+    const size_t stop_count = stops_.size();
+    for (size_t round = 0; round < search.round_count; ++round) {
+        const double arrival = search.arrivals[round * stop_count + *target];
+        // A round that does not improve the time only adds a bus
+        if (arrival == UNREACHED || (round > 0 && arrival >= search.arrivals[(round - 1) * stop_count + *target])) {
+            continue;
+        }
+        routes.push_back(*ExtractRoute(search, settings, *target, round));
+    }
+    return routes;
+}
+
+RaptorRouter::Search& RaptorRouter::GetPooledSearch() {
+    thread_local Search search;
+    return search;
+}
+
+void RaptorRouter::RunSearch(Search& search, const RouteSettings& settings, StopIndex source, std::optional<StopIndex> target,
+                             double max_time) const {
+    const size_t stop_count = stops_.size();
+    const double wait_time = static_cast<double>(settings.bus_wait_time);
+
+    search.round_count = 1;
+    search.arrivals.assign(stop_count, UNREACHED);
+    search.labels.assign(stop_count, Label{});
+    search.arrivals[source] = 0.0;
+
+    auto& best_arrivals = search.best_arrivals;
+    auto& marked_stops = search.marked_stops;
+    auto& is_marked = search.is_marked;
+    auto& marked_patterns = search.marked_patterns;
+    auto& first_positions = search.first_positions;
+    best_arrivals.assign(stop_count, UNREACHED);
+    best_arrivals[source] = 0.0;
+    marked_stops.assign(1, source);
+    is_marked.assign(stop_count, false);
+    marked_patterns.clear();
+    first_positions.assign(patterns_.size(), NO_POSITION);
+
+    while (!marked_stops.empty()) {
+        for (const StopIndex stop : marked_stops) {
+            is_marked[stop] = false;
+            for (uint32_t i = stop_visit_offsets_[stop]; i < stop_visit_offsets_[stop + 1]; ++i) {
+                const auto [pattern, position] = stop_visits_[i];
+                if (first_positions[pattern] == NO_POSITION) {
+                    marked_patterns.push_back(pattern);
+                }
+                first_positions[pattern] = std::min(first_positions[pattern], position);
+            }
+        }
+        marked_stops.clear();
+        std::sort(marked_patterns.begin(), marked_patterns.end());
+
+        // Routes with k rides start as the routes with k - 1 ones
+        const size_t round = search.round_count++;
+        search.arrivals.resize(search.round_count * stop_count);
+        search.labels.resize(search.round_count * stop_count);
+        std::copy_n(search.arrivals.begin() + (round - 1) * stop_count, stop_count, search.arrivals.begin() + round * stop_count);
+        std::copy_n(search.labels.begin() + (round - 1) * stop_count, stop_count, search.labels.begin() + round * stop_count);
+        const double* prev_arrivals = search.arrivals.data() + (round - 1) * stop_count;
+        double* arrivals = search.arrivals.data() + round * stop_count;
+        Label* labels = search.labels.data() + round * stop_count;
+
+        for (const PatternIndex pattern_index : marked_patterns) {
+            const Pattern& pattern = patterns_[pattern_index];
+            const StopIndex* stops = pattern_stops_.data() + pattern.first;
+            const double* distances = pattern_distances_.data() + pattern.first;
+            uint32_t board_position = NO_POSITION;
+            double board_time = UNREACHED;
+
+            for (uint32_t position = first_positions[pattern_index]; position < pattern.size; ++position) {
+                const StopIndex stop = stops[position];
+                double ride_time = UNREACHED;
+
+                if (board_position != NO_POSITION) {
+                    ride_time = board_time + CalculateTime(settings, distances[position] - distances[board_position]);
+                    // Nothing worse than the best route to the target can be a part of it
+                    const double bound = target ? std::min(best_arrivals[stop], best_arrivals[*target]) : best_arrivals[stop];
+                    if (ride_time < bound && ride_time <= max_time) {
+                        best_arrivals[stop] = ride_time;
+                        arrivals[stop] = ride_time;
+                        labels[stop] = { pattern_index, board_position, position, static_cast<uint32_t>(round) };
+                        if (!is_marked[stop]) {
+                            is_marked[stop] = true;
+                            marked_stops.push_back(stop);
+                        }
+                    }
+                }
+
+                // Getting on here is cheaper than staying on the bus boarded earlier
+                if (prev_arrivals[stop] + wait_time < ride_time) {
+                    board_position = position;
+                    board_time = prev_arrivals[stop] + wait_time;
+                }
+            }
+            first_positions[pattern_index] = NO_POSITION;
+        }
+        marked_patterns.clear();
+    }
+}
+
+std::optional<std::vector<RouteItems>> RaptorRouter::ExtractRoute(const Search& search, const RouteSettings& settings, StopIndex target,
+                                                                  std::optional<size_t> round) const {
+    const size_t stop_count = stops_.size();
+    const size_t last_round = round.value_or(search.round_count - 1);
+    if (search.arrivals[last_round * stop_count + target] == UNREACHED) {
+        return std::nullopt;
+    }
+
+    std::vector<Label> rides;
+    StopIndex stop = target;
+    for (Label label = search.labels[last_round * stop_count + target];
+         label.pattern != NO_PATTERN;
+         label = search.labels[(label.round - 1) * stop_count + stop])
+    {
+        rides.push_back(label);
+        stop = pattern_stops_[patterns_[label.pattern].first + label.board_position];
+    }
+
+    std::vector<RouteItems> items;
+    items.reserve(rides.size() * 2);
+    for (auto it = rides.rbegin(); it != rides.rend(); ++it) {
+        const Pattern& pattern = patterns_[it->pattern];
+        const double* distances = pattern_distances_.data() + pattern.first;
+        const Stop& board_stop = catalogue_.GetStop(stops_[pattern_stops_[pattern.first + it->board_position]]);
+
+        items.push_back({ "Wait", board_stop.name, static_cast<double>(settings.bus_wait_time) });
+        items.push_back({ "Bus", pattern.bus->name, CalculateTime(settings, distances[it->alight_position] - distances[it->board_position]),
+                          static_cast<int>(it->alight_position - it->board_position) });
+    }
+    return items;
+}
+
+size_t RaptorRouter::GetStopCount() const {
+    return stops_.size();
+}
+
+size_t RaptorRouter::GetPatternCount() const {
+    return patterns_.size();
+}
+
+size_t RaptorRouter::GetMemoryUsage() const {
+    return stop_indexes_.capacity() * sizeof(StopIndex)
+        + stops_.capacity() * sizeof(StopId)
+        + patterns_.capacity() * sizeof(Pattern)
+        + first_patterns_.capacity() * sizeof(PatternIndex)
+        + pattern_stops_.capacity() * sizeof(StopIndex)
+        + pattern_distances_.capacity() * sizeof(double)
+        + stop_visit_offsets_.capacity() * sizeof(uint32_t)
+        + stop_visits_.capacity() * sizeof(PatternVisit);
+}
+
+double RaptorRouter::CalculateTime(const RouteSettings& settings, double distance) {
+    return distance / settings.bus_velocity / 1000.0 * 60.0;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Round-based router (RAPTOR) over the bus routes themselves, no ride graph is built.
+// Round k finds the best routes with k rides: it scans the bus patterns passing through
+// the stops improved in round k - 1 and boards them wherever that is cheaper than staying on.
+// The timetable keeps road distances only, so every query takes the wait time and the velocity of its own
+class RaptorRouter {
+public:
+    explicit RaptorRouter(const transport_catalogue::TransportCatalogue& catalogue);
+
+    // std::nullopt if there is no route or a stop is not served by any bus
+    std::optional<std::vector<RouteItems>> FindRoute(const Stop* from, const Stop* to, const RouteSettings& settings) const;
+    // One search from the stop gives the routes to all targets
+    std::vector<std::optional<std::vector<RouteItems>>> FindRoutes(const Stop* from, const std::vector<const Stop*>& to,
+                                                                   const RouteSettings& settings) const;
+    // Stops reachable within max_time with their times, in no particular order
+    std::vector<std::pair<const Stop*, double>> FindReachableStops(const Stop* from, double max_time, const RouteSettings& settings) const;
+    // Pareto set of (total time, number of buses): for every number of buses the fastest route that is faster than
+    // all routes with fewer buses, in the order of the number of buses. Empty if there is no route
+    std::vector<std::vector<RouteItems>> FindParetoRoutes(const Stop* from, const Stop* to, const RouteSettings& settings) const;
+
+    // Called after TransportCatalogue::SetDistance for the buses through the changed stops: the patterns keep
+    // their stops and get the new distances in place. Buses newer than the router are skipped
+    void UpdateDistances(const std::vector<BusId>& buses);
+
+    size_t GetStopCount() const;
+    size_t GetPatternCount() const;
+    size_t GetMemoryUsage() const;
+
+private:
+    using StopIndex = uint32_t;
+    using PatternIndex = uint32_t;
+
+    // Stop sequence of a bus in one direction, a slice of pattern_stops_ and pattern_distances_
+    struct Pattern {
+        const Bus* bus = nullptr;
+        uint32_t first = 0;
+        uint32_t size = 0;
+    };
+
+    struct PatternVisit {
+        PatternIndex pattern = 0;
+        uint32_t position = 0;
+    };
+
+    // The last ride of the best route to a stop; pattern is NO_PATTERN for the source
+    struct Label {
+        PatternIndex pattern = NO_PATTERN;
+        uint32_t board_position = 0;
+        uint32_t alight_position = 0;
+        uint32_t round = 0;
+    };
+
+    // Round-major label tables: arrivals[k * stop_count + s] is the best time at s with at most k rides.
+    // One search per thread is pooled, so the tables and the scratch arrays keep their capacity between queries
+    struct Search {
+        size_t round_count = 0;
+        std::vector<double> arrivals;
+        std::vector<Label> labels;
+
+        std::vector<double> best_arrivals;
+        std::vector<StopIndex> marked_stops;
+        std::vector<bool> is_marked;
+        std::vector<PatternIndex> marked_patterns;
+        // The earliest position of a marked stop in every marked pattern, the scan starts there
+        std::vector<uint32_t> first_positions;
+    };
+
+    void AddPattern(const Bus* bus, size_t size, bool is_backward);
+    void SetPatternDistances(const Pattern& pattern);
+    void AddStopVisits();
+    std::optional<StopIndex> GetStopIndex(const Stop* stop) const;
+    static Search& GetPooledSearch();
+    // Arrivals later than max_time are not recorded
+    void RunSearch(Search& search, const RouteSettings& settings, StopIndex source, std::optional<StopIndex> target,
+                   double max_time = UNREACHED) const;
+    // The best route with at most `round` rides, the last round if not given
+    std::optional<std::vector<RouteItems>> ExtractRoute(const Search& search, const RouteSettings& settings, StopIndex target,
+                                                        std::optional<size_t> round = std::nullopt) const;
+    static double CalculateTime(const RouteSettings& settings, double distance);
+
+    static constexpr PatternIndex NO_PATTERN = std::numeric_limits<PatternIndex>::max();
+    static constexpr uint32_t NO_POSITION = std::numeric_limits<uint32_t>::max();
+    static constexpr StopIndex NO_STOP = std::numeric_limits<StopIndex>::max();
+    static constexpr double UNREACHED = std::numeric_limits<double>::infinity();
+
+    const transport_catalogue::TransportCatalogue& catalogue_;
+    // By StopId, NO_STOP for the stops no bus passes
+    std::vector<StopIndex> stop_indexes_;
+    std::vector<StopId> stops_;
+    std::vector<Pattern> patterns_;
+    // The forward pattern by BusId, the backward one follows it; NO_PATTERN for the buses that are not there
+    std::vector<PatternIndex> first_patterns_;
+    std::vector<StopIndex> pattern_stops_;
+    // Road distance from the start of the pattern
+    std::vector<double> pattern_distances_;
+    // Visits of stop s are stop_visits_[stop_visit_offsets_[s]] .. stop_visits_[stop_visit_offsets_[s + 1] - 1]
+    std::vector<uint32_t> stop_visit_offsets_;
+    std::vector<PatternVisit> stop_visits_;
+};
@@ -1,12 +1,17 @@
 #pragma once
 
 #include "graph.h"
+#include "router_base.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <optional>
+#include <queue>
+#include <span>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
@@ -15,103 +20,250 @@
 namespace graph {
 
 template <typename Weight>
-class Router {
+class Router : public RouterBase<Weight> {
 private:
     using Graph = DirectedWeightedGraph<Weight>;
 
 public:
-    explicit Router(const Graph& graph);
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
 
-    struct RouteInfo {
-        Weight weight;
-        std::vector<EdgeId> edges;
+    // 8 bytes per cell: NO_STORED_ROUTE weight marks a missing route, NO_STORED_EDGE an empty one
+    struct RouteInternalData {
+        StoredWeight weight = NO_STORED_ROUTE;
+        StoredEdgeId prev_edge = NO_STORED_EDGE;
     };
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    explicit Router(const Graph& graph);
+    // Takes a table computed earlier for the same graph, for example a memory-mapped snapshot.
+    // It is used in place and must outlive the router; Update works on a private copy
+    Router(const Graph& graph, std::span<const RouteInternalData> routes_internal_data);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    using EdgeChanges = typename RouterBase<Weight>::EdgeChanges;
+
+    // Rows whose routes use a heavier edge are rebuilt with Dijkstra, lighter edges are
+    // relaxed into the table through their ends: O(rows * E log V + ends * V^2) instead of O(V^3)
+    bool Update(const EdgeChanges& changes) override;
+
+    size_t GetMemoryUsage() const override;
+
+    // The whole table row by row, to be saved in a snapshot
+    std::span<const RouteInternalData> GetRoutesInternalData() const {
+        return {routes_, vertex_count_ * vertex_count_};
+    }
 
 private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
-    };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    // One contiguous vertex_count x vertex_count table, row by row
+    using RoutesInternalData = std::vector<RouteInternalData>;
+
+    // Writes always go to the owned table, the external one is copied first by Update
+    RouteInternalData& GetRouteInternalData(VertexId vertex_from, VertexId vertex_to) {
+        return routes_internal_data_[vertex_from * vertex_count_ + vertex_to];
+    }
+    const RouteInternalData& GetRouteInternalData(VertexId vertex_from, VertexId vertex_to) const {
+        return routes_[vertex_from * vertex_count_ + vertex_to];
+    }
 
     void InitializeRoutesInternalData(const Graph& graph) {
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            GetRouteInternalData(vertex, vertex) = RouteInternalData{0.0f, NO_STORED_EDGE};
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                auto& route_internal_data = GetRouteInternalData(vertex, edge.to);
+                const auto edge_weight = static_cast<StoredWeight>(edge.weight);
+                if (route_internal_data.weight > edge_weight) {
+                    route_internal_data = RouteInternalData{edge_weight, static_cast<StoredEdgeId>(edge_id)};
+                }
+            }
+        }
+    }
+
+    void RelaxRoutesInternalDataThroughVertex(VertexId vertex_through) {
+        const RouteInternalData* routes_through = &GetRouteInternalData(vertex_through, 0);
+        for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+            const RouteInternalData route_from = GetRouteInternalData(vertex_from, vertex_through);
+            if (route_from.weight == NO_STORED_ROUTE) {
+                continue;
+            }
+            RouteInternalData* routes_from = &GetRouteInternalData(vertex_from, 0);
+            for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+                const StoredWeight candidate_weight = route_from.weight + routes_through[vertex_to].weight;
+                if (candidate_weight < routes_from[vertex_to].weight) {
+                    const StoredEdgeId prev_edge = routes_through[vertex_to].prev_edge;
+                    routes_from[vertex_to] = {candidate_weight,
+                                              prev_edge != NO_STORED_EDGE ? prev_edge : route_from.prev_edge};
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    // New vertices get their own rows and columns, the old routes are kept
+    void ResizeRoutesInternalData(size_t vertex_count) {
+        RoutesInternalData routes_internal_data(vertex_count * vertex_count);
+        for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+            std::copy_n(&GetRouteInternalData(vertex_from, 0), vertex_count_,
+                        routes_internal_data.begin() + vertex_from * vertex_count);
+        }
+        for (VertexId vertex = vertex_count_; vertex < vertex_count; ++vertex) {
+            routes_internal_data[vertex * vertex_count + vertex] = RouteInternalData{0.0f, NO_STORED_EDGE};
         }
+        routes_internal_data_ = std::move(routes_internal_data);
+        routes_ = routes_internal_data_.data();
+        vertex_count_ = vertex_count;
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
+    // Single-source Dijkstra over the current graph replaces the whole row
+    void RebuildRoutesInternalDataFrom(VertexId vertex_from) {
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        std::vector<Weight> weights(vertex_count_, UNREACHED);
+        RouteInternalData* routes_from = &GetRouteInternalData(vertex_from, 0);
+        std::fill_n(routes_from, vertex_count_, RouteInternalData{});
+
+        weights[vertex_from] = ZERO_WEIGHT;
+        queue.push({ZERO_WEIGHT, vertex_from});
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weights[vertex] < weight) {
+                continue;
+            }
+            routes_from[vertex].weight = static_cast<StoredWeight>(weight);
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = weight + edge.weight;
+                if (candidate_weight < weights[edge.to]) {
+                    weights[edge.to] = candidate_weight;
+                    routes_from[edge.to].prev_edge = static_cast<StoredEdgeId>(edge_id);
+                    queue.push({candidate_weight, edge.to});
                 }
             }
         }
+        routes_from[vertex_from].prev_edge = NO_STORED_EDGE;
     }
 
     static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight UNREACHED = std::numeric_limits<Weight>::max();
     const Graph& graph_;
+    size_t vertex_count_ = 0;
     RoutesInternalData routes_internal_data_;
+    // Either routes_internal_data_ or an external table
+    const RouteInternalData* routes_ = nullptr;
 };
 
+static_assert(sizeof(typename Router<double>::RouteInternalData) == 8, "Route table cells are saved in snapshots");
+
 template <typename Weight>
 Router<Weight>::Router(const Graph& graph)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , vertex_count_(graph.GetVertexCount())
 {
+    CheckStoredEdgeCount(graph);
+    routes_internal_data_.resize(vertex_count_ * vertex_count_);
     InitializeRoutesInternalData(graph);
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    for (VertexId vertex_through = 0; vertex_through < vertex_count_; ++vertex_through) {
+        RelaxRoutesInternalDataThroughVertex(vertex_through);
+    }
+    routes_ = routes_internal_data_.data();
+}
+
+template <typename Weight>
+Router<Weight>::Router(const Graph& graph, std::span<const RouteInternalData> routes_internal_data)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , routes_(routes_internal_data.data())
+{
+    CheckStoredEdgeCount(graph);
+    if (routes_internal_data.size() != vertex_count_ * vertex_count_) {
+        throw std::invalid_argument("Route table does not match the graph");
     }
 }
 
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+    const auto& route_internal_data = GetRouteInternalData(from, to);
+    if (route_internal_data.weight == NO_STORED_ROUTE) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
+    Weight weight = ZERO_WEIGHT;
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    for (StoredEdgeId edge_id = route_internal_data.prev_edge;
+         edge_id != NO_STORED_EDGE;
+         edge_id = GetRouteInternalData(from, graph_.GetEdge(edge_id).from).prev_edge)
     {
-        edges.push_back(*edge_id);
+        edges.push_back(edge_id);
+        weight += graph_.GetEdge(edge_id).weight;
     }
     std::reverse(edges.begin(), edges.end());
 
     return RouteInfo{weight, std::move(edges)};
 }
 
-}  // namespace graph
\ No newline at end of file
+template <typename Weight>
+bool Router<Weight>::Update(const EdgeChanges& changes) {
+    CheckStoredEdgeCount(graph_);
+    if (routes_ != routes_internal_data_.data()) {
+        routes_internal_data_.assign(routes_, routes_ + vertex_count_ * vertex_count_);
+        routes_ = routes_internal_data_.data();
+    }
+    if (graph_.GetVertexCount() != vertex_count_) {
+        ResizeRoutesInternalData(graph_.GetVertexCount());
+    }
+
+    // A heavier edge can only spoil the rows whose route tree contains it: the route to its end goes through it
+    std::vector<VertexId> stale_vertexes;
+    for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+        const bool is_stale = std::any_of(changes.increased.begin(), changes.increased.end(), [&](EdgeId edge_id) {
+            return GetRouteInternalData(vertex_from, graph_.GetEdge(edge_id).to).prev_edge == edge_id;
+        });
+        if (is_stale) {
+            stale_vertexes.push_back(vertex_from);
+        }
+    }
+    for (const VertexId vertex_from : stale_vertexes) {
+        RebuildRoutesInternalDataFrom(vertex_from);
+    }
+
+    // Every route shortened by lighter edges is split by their ends into pieces that are already in the table,
+    // so relaxing through the ends is enough
+    std::vector<VertexId> vertexes_through;
+    std::vector<bool> is_through(vertex_count_, false);
+    for (const EdgeId edge_id : changes.decreased) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        auto& route_internal_data = GetRouteInternalData(edge.from, edge.to);
+        const auto edge_weight = static_cast<StoredWeight>(edge.weight);
+        if (route_internal_data.weight > edge_weight) {
+            route_internal_data = RouteInternalData{edge_weight, static_cast<StoredEdgeId>(edge_id)};
+        }
+        for (const VertexId vertex : {edge.from, edge.to}) {
+            if (!is_through[vertex]) {
+                is_through[vertex] = true;
+                vertexes_through.push_back(vertex);
+            }
+        }
+    }
+    for (const VertexId vertex_through : vertexes_through) {
+        RelaxRoutesInternalDataThroughVertex(vertex_through);
+    }
+    return true;
+}
+
+template <typename Weight>
+size_t Router<Weight>::GetMemoryUsage() const {
+    // An external table is counted too, even though its pages may be shared with other processes
+    return std::max(routes_internal_data_.capacity(), vertex_count_ * vertex_count_) * sizeof(RouteInternalData);
+}
+
+}  // namespace graph
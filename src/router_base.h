@@ -0,0 +1,74 @@
+#pragma once
+
+#include "graph.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace graph {
+
+// Cells of the precomputed all-pairs tables are kept compact: a float weight and a 32-bit edge id.
+// Weights are only compared in float, the weight of a found route is summed up from the graph edges
+using StoredWeight = float;
+using StoredEdgeId = uint32_t;
+
+inline constexpr StoredWeight NO_STORED_ROUTE = std::numeric_limits<StoredWeight>::infinity();
+inline constexpr StoredEdgeId NO_STORED_EDGE = std::numeric_limits<StoredEdgeId>::max();
+
+template <typename Weight>
+void CheckStoredEdgeCount(const DirectedWeightedGraph<Weight>& graph) {
+    if (graph.GetEdgeCount() >= NO_STORED_EDGE) {
+        throw std::length_error("Too many edges for a 32-bit route table");
+    }
+}
+
+// Common interface of the routing engines, so TransportRouter can pick one at runtime
+template <typename Weight>
+class RouterBase {
+public:
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    virtual ~RouterBase() = default;
+
+    virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+
+    // routes[i][j] is the route from sources[i] to targets[j]
+    using RouteMatrix = std::vector<std::vector<std::optional<RouteInfo>>>;
+
+    // Engines override it when they can share work between the pairs
+    virtual RouteMatrix BuildRoutes(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets) const {
+        RouteMatrix routes(sources.size());
+        for (size_t i = 0; i < sources.size(); ++i) {
+            routes[i].reserve(targets.size());
+            for (const VertexId to : targets) {
+                routes[i].push_back(BuildRoute(sources[i], to));
+            }
+        }
+        return routes;
+    }
+
+    // Edges changed in place after the engine was built, new vertices may have been added too
+    struct EdgeChanges {
+        // Heavier or removed edges
+        std::vector<EdgeId> increased;
+        // Lighter or new edges
+        std::vector<EdgeId> decreased;
+    };
+
+    // Repairs the engine data after the graph changed. Engines that can not do it return false
+    // and have to be built again
+    virtual bool Update(const EdgeChanges&) {
+        return false;
+    }
+
+    // Bytes taken by the data the engine keeps between queries, the graph itself is not counted
+    virtual size_t GetMemoryUsage() const = 0;
+};
+
+}  // namespace graph
@@ -0,0 +1,231 @@
+#include "router_snapshot.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TRANSPORT_CATALOGUE_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace snapshot {
+
+namespace {
+
+constexpr char MAGIC[8] = { 'T', 'C', 'R', 'O', 'U', 'T', 'E', '\0' };
+// Every table starts on a cache line boundary of the mapping
+constexpr uint64_t ROUTES_ALIGNMENT = 64;
+
+uint64_t AlignRoutes(uint64_t offset) {
+    return (offset + ROUTES_ALIGNMENT - 1) / ROUTES_ALIGNMENT * ROUTES_ALIGNMENT;
+}
+
+struct Header {
+    char magic[8] = {};
+    uint32_t version = 0;
+    uint32_t routes_cell_size = 0;
+    uint64_t fingerprint = 0;
+    uint64_t stop_count = 0;
+    uint64_t bus_count = 0;
+    uint64_t vertex_count = 0;
+    uint64_t edge_count = 0;
+    uint64_t names_offset = 0;
+    uint64_t vertexes_offset = 0;
+    uint64_t edges_offset = 0;
+    uint64_t routes_offset = 0;
+    // The size of one table, the next one starts at the next aligned offset
+    uint64_t routes_size = 0;
+    uint64_t routes_count = 0;
+};
+
+static_assert(sizeof(VertexRecord) == 12, "VertexRecord is a part of the file format");
+static_assert(sizeof(EdgeRecord) == 40, "EdgeRecord is a part of the file format");
+
+void WriteName(std::ostream& out, std::string_view name) {
+    const auto size = static_cast<uint32_t>(name.size());
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.write(name.data(), name.size());
+}
+
+}  // namespace
+
+void Save(const std::filesystem::path& path, const RouterData& data) {
+    auto temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Can not write the router snapshot " + temp_path.string());
+        }
+
+        Header header;
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = FORMAT_VERSION;
+        header.routes_cell_size = data.routes_cell_size;
+        header.fingerprint = data.fingerprint;
+        header.stop_count = data.stop_names.size();
+        header.bus_count = data.bus_names.size();
+        header.vertex_count = data.vertexes.size();
+        header.edge_count = data.edges.size();
+        header.names_offset = sizeof(Header);
+        out.seekp(sizeof(Header));
+
+        for (const auto name : data.stop_names) {
+            WriteName(out, name);
+        }
+        for (const auto name : data.bus_names) {
+            WriteName(out, name);
+        }
+
+        header.vertexes_offset = static_cast<uint64_t>(out.tellp());
+        out.write(reinterpret_cast<const char*>(data.vertexes.data()), data.vertexes.size() * sizeof(VertexRecord));
+
+        header.edges_offset = static_cast<uint64_t>(out.tellp());
+        out.write(reinterpret_cast<const char*>(data.edges.data()), data.edges.size() * sizeof(EdgeRecord));
+
+        for (const auto routes : data.routes) {
+            if (header.routes_count > 0 && routes.size() != header.routes_size) {
+                throw std::invalid_argument("Floyd-Warshall tables of a snapshot must be of the same size");
+            }
+            const auto end = static_cast<uint64_t>(out.tellp());
+            const uint64_t offset = AlignRoutes(end);
+            if (header.routes_count++ == 0) {
+                header.routes_offset = offset;
+                header.routes_size = routes.size();
+            }
+            const std::string padding(offset - end, '\0');
+            out.write(padding.data(), padding.size());
+            out.write(reinterpret_cast<const char*>(routes.data()), routes.size());
+        }
+
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!out) {
+            throw std::runtime_error("Can not write the router snapshot " + temp_path.string());
+        }
+    }
+    std::filesystem::rename(temp_path, path);
+}
+
+std::unique_ptr<MappedSnapshot> MappedSnapshot::Open(const std::filesystem::path& path) {
+    std::unique_ptr<MappedSnapshot> snapshot(new MappedSnapshot());
+
+#ifdef TRANSPORT_CATALOGUE_HAS_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat file_stat {};
+    if (::fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    const auto size = static_cast<size_t>(file_stat.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    snapshot->mapping_ = mapping;
+    snapshot->bytes_ = { static_cast<const std::byte*>(mapping), size };
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        return nullptr;
+    }
+    snapshot->buffer_.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(snapshot->buffer_.data()), snapshot->buffer_.size());
+    if (!in) {
+        return nullptr;
+    }
+    snapshot->bytes_ = snapshot->buffer_;
+#endif
+
+    if (!snapshot->Parse()) {
+        return nullptr;
+    }
+    return snapshot;
+}
+
+MappedSnapshot::~MappedSnapshot() {
+#ifdef TRANSPORT_CATALOGUE_HAS_MMAP
+    if (mapping_ != nullptr) {
+        ::munmap(mapping_, bytes_.size());
+    }
+#endif
+}
+
+const RouterData& MappedSnapshot::GetData() const {
+    return data_;
+}
+
+bool MappedSnapshot::Parse() {
+    Header header;
+    if (bytes_.size() < sizeof(Header)) {
+        return false;
+    }
+    std::memcpy(&header, bytes_.data(), sizeof(Header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != FORMAT_VERSION) {
+        return false;
+    }
+
+    // Every section is checked against the file size, a truncated file is not a snapshot
+    uint64_t offset = header.names_offset;
+    const auto read_names = [&](uint64_t count, std::vector<std::string_view>& names) {
+        names.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            uint32_t size = 0;
+            if (offset + sizeof(size) > bytes_.size()) {
+                return false;
+            }
+            std::memcpy(&size, bytes_.data() + offset, sizeof(size));
+            offset += sizeof(size);
+            if (offset + size > bytes_.size()) {
+                return false;
+            }
+            names.emplace_back(reinterpret_cast<const char*>(bytes_.data() + offset), size);
+            offset += size;
+        }
+        return true;
+    };
+    if (!read_names(header.stop_count, data_.stop_names) || !read_names(header.bus_count, data_.bus_names)) {
+        return false;
+    }
+
+    if (header.vertexes_offset + header.vertex_count * sizeof(VertexRecord) > bytes_.size()) {
+        return false;
+    }
+    data_.vertexes.resize(header.vertex_count);
+    std::memcpy(data_.vertexes.data(), bytes_.data() + header.vertexes_offset, header.vertex_count * sizeof(VertexRecord));
+
+    if (header.edges_offset + header.edge_count * sizeof(EdgeRecord) > bytes_.size()) {
+        return false;
+    }
+    data_.edges.resize(header.edge_count);
+    std::memcpy(data_.edges.data(), bytes_.data() + header.edges_offset, header.edge_count * sizeof(EdgeRecord));
+
+    // The tables are not copied: they are used right in the mapping
+    uint64_t routes_offset = header.routes_offset;
+    if (header.routes_count > 0 && header.routes_size == 0) {
+        return false;
+    }
+    for (uint64_t i = 0; i < header.routes_count; ++i) {
+        if (routes_offset + header.routes_size > bytes_.size()) {
+            return false;
+        }
+        data_.routes.push_back(bytes_.subspan(routes_offset, header.routes_size));
+        routes_offset = AlignRoutes(routes_offset + header.routes_size);
+    }
+    data_.routes_cell_size = header.routes_cell_size;
+    data_.fingerprint = header.fingerprint;
+    return true;
+}
+
+}  // namespace snapshot
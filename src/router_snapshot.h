@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace snapshot {
+
+// Bumped on every change of the file layout, files of other versions are ignored
+inline constexpr uint32_t FORMAT_VERSION = 4;
+inline constexpr uint32_t NO_BUS = std::numeric_limits<uint32_t>::max();
+
+// Fixed-size vertex record as it lies in the file
+struct VertexRecord {
+    // Index in RouterData::stop_names
+    uint32_t stop = 0;
+    // Index in RouterData::bus_names, NO_BUS if the vertex belongs to the stop itself
+    uint32_t bus = NO_BUS;
+    // TransportRouter's own tag of the vertex role
+    uint32_t type = 0;
+};
+
+// Fixed-size edge record as it lies in the file
+struct EdgeRecord {
+    uint32_t from = 0;
+    uint32_t to = 0;
+    double weight = 0.0;
+    // Road distance of a ride, the weights of the other routing profiles are made from it
+    double distance = 0.0;
+    // Index in RouterData::bus_names, NO_BUS for a wait edge
+    uint32_t bus = NO_BUS;
+    int32_t span_count = 0;
+    // Removed edges keep their ids, the routes table refers to edges by id
+    uint32_t is_removed = 0;
+    uint32_t reserved = 0;
+};
+
+// Everything TransportRouter needs to restore itself without rebuilding
+struct RouterData {
+    // Hash of the catalogue and the settings the router was built from
+    uint64_t fingerprint = 0;
+    std::vector<std::string_view> stop_names;
+    std::vector<std::string_view> bus_names;
+    std::vector<VertexRecord> vertexes;
+    std::vector<EdgeRecord> edges;
+    // Raw Floyd-Warshall tables of routes_cell_size byte cells, one per routing profile in the order of
+    // their names, all of the same size; none if the engine keeps no table
+    std::vector<std::span<const std::byte>> routes;
+    uint32_t routes_cell_size = 0;
+};
+
+// Writes to a temporary file first and renames it, so readers never see a half-written snapshot
+void Save(const std::filesystem::path& path, const RouterData& data);
+
+// Read-only view of a snapshot file. On POSIX systems the file is memory-mapped, so the table is paged in
+// on demand and shared between processes; elsewhere it is read into memory
+class MappedSnapshot {
+public:
+    // nullptr if the file is missing, truncated or has another format version
+    static std::unique_ptr<MappedSnapshot> Open(const std::filesystem::path& path);
+
+    MappedSnapshot(const MappedSnapshot&) = delete;
+    MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+    ~MappedSnapshot();
+
+    // Names and the table point into the mapping and live as long as the snapshot
+    const RouterData& GetData() const;
+
+private:
+    MappedSnapshot() = default;
+    bool Parse();
+
+    std::span<const std::byte> bytes_;
+    void* mapping_ = nullptr;
+    std::vector<std::byte> buffer_;
+    RouterData data_;
+};
+
+}  // namespace snapshot
@@ -0,0 +1,332 @@
+#pragma once
+
+#include "graph.h"
+#include "min_plus_kernel.h"
+#include "router_base.h"
+
+#include <algorithm>
+#include <barrier>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Allocator for the route tables, so every tile row starts on a cache line boundary
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+    static constexpr std::align_val_t ALIGNMENT{64};
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {
+    }
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), ALIGNMENT));
+    }
+    void deallocate(T* ptr, size_t) {
+        ::operator delete(ptr, ALIGNMENT);
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>&) const {
+        return true;
+    }
+};
+
+// All-pairs Floyd-Warshall over square tiles of a flat route table.
+// Each k-block is processed in three phases: the diagonal tile, the tiles of its row and column,
+// then all other tiles. Tiles inside a phase are independent and are spread across the threads
+template <typename Weight>
+class TiledRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    // thread_count == 0 means one thread per hardware core
+    explicit TiledRouter(const Graph& graph, size_t thread_count = 0);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    using EdgeChanges = typename RouterBase<Weight>::EdgeChanges;
+
+    // The repair of Router::Update on the padded table: the rows using a heavier edge are rebuilt with Dijkstra,
+    // lighter edges are relaxed through their ends on one thread
+    bool Update(const EdgeChanges& changes) override;
+
+    size_t GetMemoryUsage() const override;
+
+private:
+    void InitializeRoutes(const Graph& graph);
+    void RelaxTile(size_t tile_row, size_t tile_column, size_t tile_through);
+    void RunPhases(size_t thread_id, size_t thread_count, std::barrier<>& sync_point);
+    // New vertices get their own rows and columns, the table is copied only if they do not fit into the padding
+    void Resize(size_t vertex_count);
+    void RebuildRow(VertexId vertex_from);
+    void RelaxThroughVertex(VertexId vertex_through);
+
+    static constexpr size_t TILE_SIZE = 64;
+    static_assert(TILE_SIZE % 8 == 0, "RelaxMinPlusTile takes eight cells at a time");
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight UNREACHED = std::numeric_limits<Weight>::max();
+
+    const Graph& graph_;
+    size_t vertex_count_ = 0;
+    // Size of a padded table row, a multiple of TILE_SIZE
+    size_t stride_ = 0;
+    std::vector<StoredWeight, AlignedAllocator<StoredWeight>> weights_;
+    // The last edge of the route, NO_STORED_EDGE for an empty one
+    std::vector<StoredEdgeId, AlignedAllocator<StoredEdgeId>> prev_edges_;
+};
+
+template <typename Weight>
+TiledRouter<Weight>::TiledRouter(const Graph& graph, size_t thread_count)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , stride_((graph.GetVertexCount() + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE)
+    , weights_(stride_ * stride_, NO_STORED_ROUTE)
+    , prev_edges_(stride_ * stride_, NO_STORED_EDGE)
+{
+    CheckStoredEdgeCount(graph);
+    InitializeRoutes(graph);
+
+    const size_t tile_count = stride_ / TILE_SIZE;
+    if (thread_count == 0) {
+        thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    // More threads than tiles in the last phase have nothing to do
+    thread_count = std::max<size_t>(std::min(thread_count, tile_count * tile_count), 1);
+
+    std::barrier sync_point(static_cast<std::ptrdiff_t>(thread_count));
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count - 1);
+    for (size_t thread_id = 1; thread_id < thread_count; ++thread_id) {
+        workers.emplace_back([this, thread_id, thread_count, &sync_point] {
+            RunPhases(thread_id, thread_count, sync_point);
+        });
+    }
+    RunPhases(0, thread_count, sync_point);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+template <typename Weight>
+void TiledRouter<Weight>::InitializeRoutes(const Graph& graph) {
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        weights_[vertex * stride_ + vertex] = 0.0f;
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            const size_t cell = vertex * stride_ + edge.to;
+            const auto edge_weight = static_cast<StoredWeight>(edge.weight);
+            if (weights_[cell] > edge_weight) {
+                weights_[cell] = edge_weight;
+                prev_edges_[cell] = static_cast<StoredEdgeId>(edge_id);
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void TiledRouter<Weight>::RelaxTile(size_t tile_row, size_t tile_column, size_t tile_through) {
+    RelaxMinPlusTile(weights_.data(), prev_edges_.data(), stride_, tile_row * TILE_SIZE, tile_column * TILE_SIZE, tile_through * TILE_SIZE,
+                     TILE_SIZE);
+}
+
+template <typename Weight>
+void TiledRouter<Weight>::RunPhases(size_t thread_id, size_t thread_count, std::barrier<>& sync_point) {
+    const size_t tile_count = stride_ / TILE_SIZE;
+
+    for (size_t tile_through = 0; tile_through < tile_count; ++tile_through) {
+        if (thread_id == 0) {
+            RelaxTile(tile_through, tile_through, tile_through);
+        }
+        sync_point.arrive_and_wait();
+
+        // Row and column of the diagonal tile: tile i < tile_count - 1 is a row one, the rest are column ones
+        for (size_t task = thread_id; task + 2 < 2 * tile_count; task += thread_count) {
+            const size_t index = task % (tile_count - 1);
+            const size_t tile = index < tile_through ? index : index + 1;
+            if (task < tile_count - 1) {
+                RelaxTile(tile_through, tile, tile_through);
+            }
+            else {
+                RelaxTile(tile, tile_through, tile_through);
+            }
+        }
+        sync_point.arrive_and_wait();
+
+        for (size_t task = thread_id; task < tile_count * tile_count; task += thread_count) {
+            const size_t tile_row = task / tile_count;
+            const size_t tile_column = task % tile_count;
+            if (tile_row != tile_through && tile_column != tile_through) {
+                RelaxTile(tile_row, tile_column, tile_through);
+            }
+        }
+        sync_point.arrive_and_wait();
+    }
+}
+
+template <typename Weight>
+std::optional<typename TiledRouter<Weight>::RouteInfo> TiledRouter<Weight>::BuildRoute(VertexId from,
+                                                                                       VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+    if (weights_[from * stride_ + to] == NO_STORED_ROUTE) {
+        return std::nullopt;
+    }
+
+    Weight weight = ZERO_WEIGHT;
+    std::vector<EdgeId> edges;
+    for (StoredEdgeId edge_id = prev_edges_[from * stride_ + to];
+         edge_id != NO_STORED_EDGE;
+         edge_id = prev_edges_[from * stride_ + graph_.GetEdge(edge_id).from])
+    {
+        edges.push_back(edge_id);
+        weight += graph_.GetEdge(edge_id).weight;
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{weight, std::move(edges)};
+}
+
+template <typename Weight>
+bool TiledRouter<Weight>::Update(const EdgeChanges& changes) {
+    CheckStoredEdgeCount(graph_);
+    if (graph_.GetVertexCount() != vertex_count_) {
+        Resize(graph_.GetVertexCount());
+    }
+
+    // A heavier edge can only spoil the rows whose route tree contains it
+    std::vector<VertexId> stale_vertexes;
+    for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+        const bool is_stale = std::any_of(changes.increased.begin(), changes.increased.end(), [&](EdgeId edge_id) {
+            return prev_edges_[vertex_from * stride_ + graph_.GetEdge(edge_id).to] == edge_id;
+        });
+        if (is_stale) {
+            stale_vertexes.push_back(vertex_from);
+        }
+    }
+    for (const VertexId vertex_from : stale_vertexes) {
+        RebuildRow(vertex_from);
+    }
+
+    std::vector<VertexId> vertexes_through;
+    std::vector<bool> is_through(vertex_count_, false);
+    for (const EdgeId edge_id : changes.decreased) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        const size_t cell = edge.from * stride_ + edge.to;
+        const auto edge_weight = static_cast<StoredWeight>(edge.weight);
+        if (weights_[cell] > edge_weight) {
+            weights_[cell] = edge_weight;
+            prev_edges_[cell] = static_cast<StoredEdgeId>(edge_id);
+        }
+        for (const VertexId vertex : {edge.from, edge.to}) {
+            if (!is_through[vertex]) {
+                is_through[vertex] = true;
+                vertexes_through.push_back(vertex);
+            }
+        }
+    }
+    for (const VertexId vertex_through : vertexes_through) {
+        RelaxThroughVertex(vertex_through);
+    }
+    return true;
+}
+
+template <typename Weight>
+void TiledRouter<Weight>::Resize(size_t vertex_count) {
+    const size_t stride = (vertex_count + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE;
+    if (stride != stride_) {
+        std::vector<StoredWeight, AlignedAllocator<StoredWeight>> weights(stride * stride, NO_STORED_ROUTE);
+        std::vector<StoredEdgeId, AlignedAllocator<StoredEdgeId>> prev_edges(stride * stride, NO_STORED_EDGE);
+        for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+            std::copy_n(weights_.begin() + vertex_from * stride_, vertex_count_, weights.begin() + vertex_from * stride);
+            std::copy_n(prev_edges_.begin() + vertex_from * stride_, vertex_count_, prev_edges.begin() + vertex_from * stride);
+        }
+        weights_ = std::move(weights);
+        prev_edges_ = std::move(prev_edges);
+        stride_ = stride;
+    }
+    for (VertexId vertex = vertex_count_; vertex < vertex_count; ++vertex) {
+        weights_[vertex * stride_ + vertex] = 0.0f;
+    }
+    vertex_count_ = vertex_count;
+}
+
+template <typename Weight>
+void TiledRouter<Weight>::RebuildRow(VertexId vertex_from) {
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    std::vector<Weight> weights(vertex_count_, UNREACHED);
+    StoredWeight* row_weights = weights_.data() + vertex_from * stride_;
+    StoredEdgeId* row_prev_edges = prev_edges_.data() + vertex_from * stride_;
+    std::fill_n(row_weights, vertex_count_, NO_STORED_ROUTE);
+    std::fill_n(row_prev_edges, vertex_count_, NO_STORED_EDGE);
+
+    weights[vertex_from] = ZERO_WEIGHT;
+    queue.push({ZERO_WEIGHT, vertex_from});
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weights[vertex] < weight) {
+            continue;
+        }
+        row_weights[vertex] = static_cast<StoredWeight>(weight);
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const Weight candidate_weight = weight + edge.weight;
+            if (candidate_weight < weights[edge.to]) {
+                weights[edge.to] = candidate_weight;
+                row_prev_edges[edge.to] = static_cast<StoredEdgeId>(edge_id);
+                queue.push({candidate_weight, edge.to});
+            }
+        }
+    }
+    row_prev_edges[vertex_from] = NO_STORED_EDGE;
+}
+
+template <typename Weight>
+void TiledRouter<Weight>::RelaxThroughVertex(VertexId vertex_through) {
+    const StoredWeight* through_weights = weights_.data() + vertex_through * stride_;
+    const StoredEdgeId* through_prev_edges = prev_edges_.data() + vertex_through * stride_;
+    for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+        const size_t row = vertex_from * stride_;
+        const StoredWeight weight_from = weights_[row + vertex_through];
+        if (weight_from == NO_STORED_ROUTE) {
+            continue;
+        }
+        const StoredEdgeId prev_edge_from = prev_edges_[row + vertex_through];
+        for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+            const StoredWeight candidate_weight = weight_from + through_weights[vertex_to];
+            if (candidate_weight < weights_[row + vertex_to]) {
+                weights_[row + vertex_to] = candidate_weight;
+                prev_edges_[row + vertex_to] = through_prev_edges[vertex_to] != NO_STORED_EDGE ? through_prev_edges[vertex_to] : prev_edge_from;
+            }
+        }
+    }
+}
+
+template <typename Weight>
+size_t TiledRouter<Weight>::GetMemoryUsage() const {
+    return weights_.capacity() * sizeof(StoredWeight) + prev_edges_.capacity() * sizeof(StoredEdgeId);
+}
+
+}  // namespace graph
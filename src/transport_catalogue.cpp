@@ -1,122 +1,245 @@
 #include "transport_catalogue.h"
 
+#include <algorithm>
 #include <cmath>
 #include <exception>
 #include <iomanip>
 #include <iostream>
 #include <functional>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 
 using namespace transport_catalogue;
 
-void TransportCatalogue::AddStop(const std::string& name, geo::Coordinates coordinates) {
-    stops_.push_back({ name, coordinates });
-    stopname_to_stop_.insert({ stops_.back().name, &stops_.back() });
-    graph::VertexId id = stops_.size() * 2;
-    stops_vertex_wait_.insert({ stops_.back().name, id - 1 });
-    stops_vertex_bus_.insert({ stops_.back().name, id });
+void TransportCatalogue::AddStop(std::string_view name, geo::Coordinates coordinates) {
+    const auto name_id = names_.Intern(name);
+    const auto id = static_cast<StopId>(stops_.size());
+    stops_.push_back({ names_.GetName(name_id), coordinates, id });
+    stop_by_name_.resize(names_.GetNameCount(), NO_ID);
+    if (stop_by_name_[name_id] == NO_ID) {
+        stop_by_name_[name_id] = id;
+    }
+    buses_in_stops_.emplace_back();
+    distances_.emplace_back();
 }
 
-void TransportCatalogue::AddBus(const std::string& name, const std::vector<std::string_view>& data, bool is_roundtrip) {
-    std::vector<const Stop*> route;
+void TransportCatalogue::AddBus(std::string_view name, const std::vector<std::string_view>& data, bool is_roundtrip) {
+    // Every stop lists a bus name once, as the bus ids are the ones kept in the lists
+    if (FindBus(name) != nullptr) {
+        throw std::invalid_argument("Bus is already in the catalogue: " + std::string(name));
+    }
+
+    std::vector<StopId> route;
+    route.reserve(data.size());
     for (auto stop : data) {
-        auto ptr = FindStop(std::string(stop));
-        route.push_back(ptr);
+        route.push_back(FindStop(stop)->id);
     }
 
-    buses_.push_back({ name, route, is_roundtrip });
+    const auto name_id = names_.Intern(name);
+    buses_.push_back({ names_.GetName(name_id), std::move(route), is_roundtrip, static_cast<BusId>(buses_.size()) });
     auto& bus = buses_.back();
-    busname_to_bus_.insert({ bus.name, &bus });
+    bus_by_name_.resize(names_.GetNameCount(), NO_ID);
+    bus_by_name_[name_id] = bus.id;
 
     for (auto stop : bus.route) {
-        buses_in_stops_[stop].insert(bus.name);
+        auto& stop_buses = buses_in_stops_[stop];
+        auto it = std::lower_bound(stop_buses.begin(), stop_buses.end(), bus.name,
+                                   [this](BusId lhs, std::string_view rhs) { return buses_[lhs].name < rhs; });
+        // A bus may pass the stop more than once
+        if (it == stop_buses.end() || *it != bus.id) {
+            stop_buses.insert(it, bus.id);
+        }
+    }
+    if (is_finalized_) {
+        bus_infos_.push_back(ComputeBusInfo(bus));
     }
 }
 
+void TransportCatalogue::RemoveBus(const std::string_view name) {
+    const Bus* bus = FindBus(name);
+    if (bus == nullptr) {
+        return;
+    }
+
+    // The bus itself stays in the deque, so pointers to it held by the router remain valid
+    for (auto stop : bus->route) {
+        std::erase(buses_in_stops_[stop], bus->id);
+    }
+    bus_by_name_[*names_.Find(name)] = NO_ID;
+}
+
 const Stop* TransportCatalogue::FindStop(const std::string_view name) const {
-    auto it = stopname_to_stop_.find(name);
+    const auto name_id = names_.Find(name);
 
-    if (it != stopname_to_stop_.end()) {
-        return it->second;
+    if (name_id && *name_id < stop_by_name_.size() && stop_by_name_[*name_id] != NO_ID) {
+        return &stops_[stop_by_name_[*name_id]];
     }
     return nullptr;
 }
 
 const Bus* TransportCatalogue::FindBus(const std::string_view name) const {
-    auto it = busname_to_bus_.find(name);
+    const auto name_id = names_.Find(name);
 
-    if (it == busname_to_bus_.end()) {
+    if (!name_id || *name_id >= bus_by_name_.size() || bus_by_name_[*name_id] == NO_ID) {
         return nullptr;
     }
 
-    return it->second;
+    return &buses_[bus_by_name_[*name_id]];
 }
 
 BusInfo TransportCatalogue::GetBusInfo(const std::string_view name) const {
-
-    BusInfo bus_info;
-    std::unordered_set<const Stop*> unique_stop;
     auto bus = FindBus(name);
 
-    if (bus != nullptr) {
-        bus_info.stops = bus->route.size();
+    if (bus == nullptr) {
+        return {};
     }
-    else {
-        return bus_info;
+    if (is_finalized_) {
+        return bus_infos_[bus->id];
     }
+    return ComputeBusInfo(*bus);
+}
+
+BusInfo TransportCatalogue::ComputeBusInfo(const Bus& bus) const {
+
+    BusInfo bus_info;
+    bus_info.stops = bus.route.size();
 
-    for (auto it = bus->route.begin(); it != bus->route.end(); ++it) {
+    for (auto it = bus.route.begin(); it != bus.route.end(); ++it) {
         auto stop = *it;
 
-        if (it != bus->route.begin()) {
-            auto bef_it = it;
-            --bef_it;
-            auto bef_stop = *bef_it;
-            bus_info.geo_distance += ComputeDistance(bef_stop->coordinates, stop->coordinates);
+        if (it != bus.route.begin()) {
+            auto bef_stop = *(it - 1);
+            bus_info.geo_distance += ComputeDistance(stops_[bef_stop].coordinates, stops_[stop].coordinates);
             bus_info.route_distance += GetDistance(bef_stop, stop);
         }
-
-        unique_stop.insert(stop);
     }
-    bus_info.unique_stop = unique_stop.size();
+
+    std::vector<StopId> unique_stop = bus.route;
+    std::sort(unique_stop.begin(), unique_stop.end());
+    bus_info.unique_stop = std::unique(unique_stop.begin(), unique_stop.end()) - unique_stop.begin();
 
     return bus_info;
 }
 
-const std::unordered_set<std::string_view>& TransportCatalogue::GetStopInfo(const std::string_view name) const {
-    static std::unordered_set<std::string_view> names;
+void TransportCatalogue::Finalize(size_t thread_count) {
+    bus_infos_.resize(buses_.size());
+    if (thread_count == 0) {
+        thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    // A thread is worth starting only for a long enough range of buses; a single range is computed right here
+    thread_count = std::max<size_t>(std::min(thread_count, buses_.size() / MIN_BUSES_PER_THREAD), 1);
+
+    // Every worker fills the stats of a contiguous range of buses, the buses are only read
+    const auto compute_shard = [this, thread_count](size_t shard) {
+        const size_t end = buses_.size() * (shard + 1) / thread_count;
+        for (size_t i = buses_.size() * shard / thread_count; i < end; ++i) {
+            bus_infos_[i] = ComputeBusInfo(buses_[i]);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count - 1);
+    for (size_t shard = 1; shard < thread_count; ++shard) {
+        workers.emplace_back(compute_shard, shard);
+    }
+    compute_shard(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    is_finalized_ = true;
+}
+
+void TransportCatalogue::UpdateBusInfos(StopId stop) {
+    for (const BusId bus : buses_in_stops_[stop]) {
+        bus_infos_[bus] = ComputeBusInfo(buses_[bus]);
+    }
+}
+
+std::span<const BusId> TransportCatalogue::GetStopInfo(const std::string_view name) const {
     const auto ptr = FindStop(name);
-    auto it_ptr = buses_in_stops_.find(ptr);
 
-    if (it_ptr != buses_in_stops_.end()) {
-        return it_ptr->second;
+    if (ptr != nullptr) {
+        return buses_in_stops_[ptr->id];
     }
     else {
-        return names;
+        return {};
     }
 }
 
-void TransportCatalogue::SetDistance(const Stop* stop_from, const Stop* stop_to, int distance) {
+const int* TransportCatalogue::FindRoadDistance(StopId stop_from, StopId stop_to) const {
+    const auto& row = distances_[stop_from];
+    auto it = std::lower_bound(row.begin(), row.end(), stop_to, [](const RoadDistance& lhs, StopId rhs) { return lhs.to < rhs; });
+    if (it == row.end() || it->to != stop_to) {
+        return nullptr;
+    }
+    return &it->distance;
+}
 
-    distances_[{stop_from, stop_to}] = distance;
+void TransportCatalogue::SetRoadDistance(StopId stop_from, StopId stop_to, int distance) {
+    auto& row = distances_[stop_from];
+    auto it = std::lower_bound(row.begin(), row.end(), stop_to, [](const RoadDistance& lhs, StopId rhs) { return lhs.to < rhs; });
+    if (it != row.end() && it->to == stop_to) {
+        it->distance = distance;
+    }
+    else {
+        row.insert(it, { stop_to, distance });
+    }
+}
 
-    if (distances_[{stop_to, stop_from}] == 0) {
-        distances_[{stop_to, stop_from}] = distance;
+void TransportCatalogue::SetDistance(StopId stop_from, StopId stop_to, int distance) {
+
+    SetRoadDistance(stop_from, stop_to, distance);
+
+    // The way back is the same unless it is set on its own
+    const int* back_distance = FindRoadDistance(stop_to, stop_from);
+    if (back_distance == nullptr || *back_distance == 0) {
+        SetRoadDistance(stop_to, stop_from, distance);
+    }
+    // Both directions are ridden only by the buses passing stop_from
+    if (is_finalized_) {
+        UpdateBusInfos(stop_from);
     }
 }
 
-int TransportCatalogue::GetDistance(const Stop* stop_from, const Stop* stop_to) const {
-    auto it = distances_.find({ stop_from ,stop_to });
-    if (it == distances_.end()) {
-        return geo::ComputeDistance(stop_from->coordinates, stop_to->coordinates);
+int TransportCatalogue::GetDistance(StopId stop_from, StopId stop_to) const {
+    const int* distance = FindRoadDistance(stop_from, stop_to);
+    if (distance == nullptr) {
+        return geo::ComputeDistance(stops_[stop_from].coordinates, stops_[stop_to].coordinates);
     }
-    return it->second;
+    return *distance;
+}
+
+std::span<const RoadDistance> TransportCatalogue::GetRoadDistances(StopId stop) const {
+    return distances_.at(stop);
+}
+
+std::span<const BusId> TransportCatalogue::GetStopBuses(StopId stop) const {
+    return buses_in_stops_.at(stop);
+}
+
+std::vector<const Bus*> TransportCatalogue::GetBuses() const {
+    std::vector<const Bus*> buses;
+    for (const Bus& bus : buses_) {
+        if (FindBus(bus.name) == &bus) {
+            buses.push_back(&bus);
+        }
+    }
+    return buses;
+}
+
+const Stop& TransportCatalogue::GetStop(StopId id) const {
+    return stops_.at(id);
+}
+
+const Bus& TransportCatalogue::GetBus(BusId id) const {
+    return buses_.at(id);
 }
 
-const std::unordered_map<std::string_view, const Stop*>& TransportCatalogue::GetStops() const {
-    return stopname_to_stop_;
+size_t TransportCatalogue::GetStopCount() const {
+    return stops_.size();
 }
 
-const std::unordered_map<std::string_view, const Bus*>& TransportCatalogue::GetBuses() const {
-    return busname_to_bus_;
+size_t TransportCatalogue::GetBusCount() const {
+    return buses_.size();
 }
\ No newline at end of file
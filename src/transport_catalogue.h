@@ -2,14 +2,15 @@
 
 #include "domain.h"
 #include "geo.h"
-#include "graph.h"
+#include "name_arena.h"
 
+#include <cstdint>
 #include <deque>
+#include <limits>
 #include <string>
 #include <string_view>
 #include <set>
-#include <unordered_map>
-#include <unordered_set>
+#include <span>
 #include <vector>
 
 namespace transport_catalogue {
@@ -21,39 +22,71 @@ namespace transport_catalogue {
 		int unique_stop = 0;
 	};
 
-	struct Hasher {
-		size_t operator() (const std::pair<const Stop*, const Stop*> elem) const {
-			size_t h_x = hasher_(elem.first);
-			size_t h_y = hasher_(elem.second);
-			return h_x + h_y * 37;
-		}
-
-	private:
-		std::hash<const Stop*> hasher_;
+	// A road distance set by SetDistance, kept in the row of the stop it starts from
+	struct RoadDistance {
+		StopId to = 0;
+		int distance = 0;
 	};
 
 	class TransportCatalogue {
 		//   
 	public:
-		void AddStop(const std::string& name, geo::Coordinates coordinates);
-		void AddBus(const std::string& name, const std::vector<std::string_view>& data, bool is_roundtrip);
+		void AddStop(std::string_view name, geo::Coordinates coordinates);
+		// Throws std::invalid_argument if a bus of the name is there already; a removed one may be added again
+		void AddBus(std::string_view name, const std::vector<std::string_view>& data, bool is_roundtrip);
+		void RemoveBus(const std::string_view name);
 		const Stop* FindStop(const std::string_view name) const;
 		const Bus* FindBus(const std::string_view name) const;
 		BusInfo GetBusInfo(const std::string_view name) const;
-		const std::unordered_set<std::string_view>& GetStopInfo(const std::string_view name) const;
-		void SetDistance(const Stop* stop_from, const Stop* stop_to, int distance);
-		int GetDistance(const Stop* stop_from, const Stop* stop_to) const;
-		const std::unordered_map<std::string_view, const Stop*>& GetStops() const;
-		const std::unordered_map<std::string_view, const Bus*>& GetBuses() const;
+		// Buses passing the stop in the order of their names, empty for an unknown stop
+		std::span<const BusId> GetStopInfo(const std::string_view name) const;
+		void SetDistance(StopId stop_from, StopId stop_to, int distance);
+		// Computes the stats of every bus once, over up to thread_count threads (0 means one per hardware core);
+		// a small catalogue is computed on the calling thread.
+		// GetBusInfo then only reads them, and the later changes of the catalogue keep them up to date
+		void Finalize(size_t thread_count = 0);
+		int GetDistance(StopId stop_from, StopId stop_to) const;
+		// The road distances set from the stop, sorted by RoadDistance::to
+		std::span<const RoadDistance> GetRoadDistances(StopId stop) const;
+		// The buses passing the stop in the order of their names
+		std::span<const BusId> GetStopBuses(StopId stop) const;
+		// The buses that are not removed, in the order of ids
+		std::vector<const Bus*> GetBuses() const;
+
+		// Ids run from 0 to the count. A removed bus keeps its id, a bus added again under its name gets a new one
+		const Stop& GetStop(StopId id) const;
+		const Bus& GetBus(BusId id) const;
+		size_t GetStopCount() const;
+		size_t GetBusCount() const;
 
 	private:
+		// nullptr if no road distance is set
+		const int* FindRoadDistance(StopId stop_from, StopId stop_to) const;
+		void SetRoadDistance(StopId stop_from, StopId stop_to, int distance);
+		BusInfo ComputeBusInfo(const Bus& bus) const;
+		// Recomputes the stats of the buses passing the stop
+		void UpdateBusInfos(StopId stop);
+
+		static constexpr uint32_t NO_ID = std::numeric_limits<uint32_t>::max();
+		// Finalize gives every thread at least this many buses
+		static constexpr size_t MIN_BUSES_PER_THREAD = 256;
+
+		// Declared first: every name below is a view of it
+		NameArena names_;
+		// Indexed by id. A deque never moves its elements, so the pointers handed out stay valid
 		std::deque<Stop> stops_;
 		std::deque<Bus> buses_;
-		std::unordered_map<std::string_view, const Stop*> stopname_to_stop_;
-		std::unordered_map<std::string_view, const Bus*> busname_to_bus_;
-		std::unordered_map<const Stop*, std::unordered_set<std::string_view>> buses_in_stops_;
-		std::unordered_map<std::pair<const Stop*, const Stop*>, int, Hasher> distances_;
-		std::unordered_map<std::string_view, graph::VertexId> stops_vertex_wait_;
-		std::unordered_map<std::string_view, graph::VertexId> stops_vertex_bus_;
+		// The stop and the current bus of every name by NameArena::NameId, NO_ID if there is none.
+		// The arena is the only hash table of the names
+		std::vector<StopId> stop_by_name_;
+		std::vector<BusId> bus_by_name_;
+		// Indexed by StopId. Every list is kept sorted by bus name as the buses come and go, so a query only walks it
+		std::vector<std::vector<BusId>> buses_in_stops_;
+		// Indexed by StopId, every row is sorted by RoadDistance::to. A stop has a handful of neighbours,
+		// so a lookup is a short binary search in one small array
+		std::vector<std::vector<RoadDistance>> distances_;
+		// Indexed by BusId, filled by Finalize
+		std::vector<BusInfo> bus_infos_;
+		bool is_finalized_ = false;
 	};
 }
\ No newline at end of file
@@ -1,127 +1,923 @@
 #include "transport_router.h"
 
+#include <algorithm>
+#include <iterator>
+#include <ranges>
+#include <thread>
+#include <tuple>
+
 TransportRouter::TransportRouter(const transport_catalogue::TransportCatalogue& catalogue, RouteSettings settings) 
-    : catalogue_(catalogue), router_(nullptr), settings_(settings) { BuildRouter(); }
+    : catalogue_(catalogue), settings_(settings)
+    , graph_model_(settings.graph_model) { BuildRouter(); }
+
+TransportRouter::TransportRouter(const transport_catalogue::TransportCatalogue& catalogue, RouteSettings settings, std::unique_ptr<snapshot::MappedSnapshot> snapshot)
+    : catalogue_(catalogue), snapshot_(std::move(snapshot)), settings_(settings)
+    , graph_model_(settings.graph_model) {}
 
-double TransportRouter::CalcDistanceAndGetTime(const Stop* from, const Stop* to, double& distance) {
+double TransportRouter::CalcDistanceAndGetTime(StopId from, StopId to, double& distance) const {
     distance += static_cast<double>(catalogue_.GetDistance(from, to));
     return CalculateTime(distance);
 }
 
-void TransportRouter::AddBuses(const std::unordered_map<std::string_view, const Bus*>& buses) {
-    for (const auto& [bus_name, bus] : buses) {
-        const auto& stops = bus->route;
-        int size = 0;
+bool TransportRouter::IsFrozenGraphEngine(RouterEngine engine) {
+    return engine == RouterEngine::DIJKSTRA || engine == RouterEngine::ALT;
+}
+
+size_t TransportRouter::GetDirectionSize(const Bus* bus) {
+    const auto& stops = bus->route;
+    if (bus->is_roundtrip) {
+        return stops.size();
+    }
+    else if (stops.size() % 2 == 0) {
+        return stops.size() / 2;
+    }
+    else {
+        return stops.size() / 2 + 1;
+    }
+}
+
+std::vector<TransportRouter::BusEdge> TransportRouter::MakeBusEdges(const Bus* bus) const {
+    return graph_model_ == GraphModel::LINEAR ? MakeLinearBusEdges(bus) : MakeCompleteBusEdges(bus);
+}
+
+std::vector<TransportRouter::BusEdge> TransportRouter::MakeCompleteBusEdges(const Bus* bus) const {
+    std::vector<BusEdge> edges;
+    const auto& stops = bus->route;
+    const int size = static_cast<int>(GetDirectionSize(bus));
+    const graph::BusId bus_id = bus->id;
+
+    for (int i(0); i < size; ++i) {
+        auto stop_from_id = GetVertexByStop(stops[i]);
+        double distance_from_to = 0.0, distance_to_from = 0.0;
+
+        for (int j = i + 1; j < size; ++j) {
+            auto stop_to_id = GetVertexByStop(stops[j]);
+
+            double time_from_to = CalcDistanceAndGetTime(stops[j - 1], stops[j], distance_from_to);
+            edges.push_back({ { stop_from_id + 1, stop_to_id, time_from_to, bus_id, j - i }, distance_from_to });
+
+            if (!bus->is_roundtrip) {
+                double time_to_from = CalcDistanceAndGetTime(stops[j], stops[j - 1], distance_to_from);
+                edges.push_back({ { stop_to_id + 1, stop_from_id, time_to_from, bus_id, std::abs(i - j) }, distance_to_from });
+            }
+        }
 
         if (bus->is_roundtrip) {
-            size = stops.size();
+            double total_time = CalculateTime(distance_from_to);
+            edges.push_back({ { stop_from_id + 1, stop_from_id, total_time, bus_id, static_cast<int>(size) }, distance_from_to });
         }
-        else if (stops.size() % 2 == 0) {
-            size = stops.size() / 2;
+    }
+    return edges;
+}
+
+std::vector<TransportRouter::BusEdge> TransportRouter::MakeLinearBusEdges(const Bus* bus) const {
+    std::vector<BusEdge> edges;
+    const auto& stops = bus->route;
+    const size_t size = GetDirectionSize(bus);
+    const double wait_time = static_cast<double>(settings_.bus_wait_time);
+
+    // Boarding at the last stop and getting off at the first one lead nowhere, so there are no such edges
+    const auto add_direction = [&](graph::VertexId first_ride_vertex, auto get_stop) {
+        for (size_t i = 0; i < size; ++i) {
+            const auto stop_vertex = GetVertexByStop(get_stop(i));
+            const auto ride_vertex = first_ride_vertex + i;
+            if (i + 1 < size) {
+                const double distance = static_cast<double>(catalogue_.GetDistance(get_stop(i), get_stop(i + 1)));
+                edges.push_back({ { stop_vertex, ride_vertex, wait_time } });
+                edges.push_back({ { ride_vertex, ride_vertex + 1, CalculateTime(distance) }, distance });
+            }
+            if (i > 0) {
+                edges.push_back({ { ride_vertex, stop_vertex, 0.0 } });
+            }
         }
-        else {
-            size = stops.size() / 2 + 1;
+    };
+
+    const auto first_ride_vertex = ride_vertexes_.at(bus->id);
+    add_direction(first_ride_vertex, [&stops](size_t i) { return stops[i]; });
+    if (!bus->is_roundtrip) {
+        add_direction(first_ride_vertex + size, [&stops, size](size_t i) { return stops[size - 1 - i]; });
+    }
+    return edges;
+}
+
+void TransportRouter::AddBuses(const std::vector<const Bus*>& ordered_buses) {
+    // Vertexes are cheap and handed out first, in the order of the buses
+    if (graph_model_ == GraphModel::LINEAR) {
+        for (const Bus* bus : ordered_buses) {
+            AddRideVertexes(bus);
+        }
+    }
+
+    size_t thread_count = settings_.thread_count;
+    if (thread_count == 0) {
+        thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    thread_count = std::max<size_t>(std::min(thread_count, ordered_buses.size()), 1);
+
+    // Every worker makes the edges of a contiguous shard of buses into its own buffer. The buffers are
+    // appended in the order of the shards, so the edge ids are the same for any number of threads
+    std::vector<std::vector<BusEdge>> shard_edges(thread_count);
+    std::vector<size_t> bus_edge_counts(ordered_buses.size());
+    const auto make_shard_edges = [&](size_t shard) {
+        const size_t end = ordered_buses.size() * (shard + 1) / thread_count;
+        for (size_t i = ordered_buses.size() * shard / thread_count; i < end; ++i) {
+            const auto edges = MakeBusEdges(ordered_buses[i]);
+            bus_edge_counts[i] = edges.size();
+            shard_edges[shard].insert(shard_edges[shard].end(), edges.begin(), edges.end());
         }
+    };
 
-        for (int i(0); i < size; ++i) {
-            auto stop_from_id = GetVertexByStop(stops[i]);
-            double distance_from_to = 0.0, distance_to_from = 0.0;
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count - 1);
+    for (size_t shard = 1; shard < thread_count; ++shard) {
+        workers.emplace_back(make_shard_edges, shard);
+    }
+    make_shard_edges(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
 
-            for (int j = i + 1; j < size; ++j) {
-                auto stop_to_id = GetVertexByStop(stops[j]);
+    graph::EdgeId edge_id = graph_.GetEdgeCount();
+    graph_.AddEdges(shard_edges | std::views::join | std::views::transform(&BusEdge::edge));
+    for (const auto& bus_edge : shard_edges | std::views::join) {
+        edge_distances_.push_back(bus_edge.distance);
+    }
+    for (size_t i = 0; i < ordered_buses.size(); ++i) {
+        auto& edge_ids = bus_edges_[ordered_buses[i]->id];
+        for (size_t j = 0; j < bus_edge_counts[i]; ++j) {
+            edge_ids.push_back(edge_id++);
+        }
+    }
+}
 
-                double time_from_to = CalcDistanceAndGetTime(stops[j - 1], stops[j], distance_from_to);
-                graph_.AddEdge({ stop_from_id + 1, stop_to_id, time_from_to, bus->name, j - i });
+graph::VertexId TransportRouter::AddVertex(const VertexInfo& info) {
+    vertexes_.push_back(info);
+    return graph_.AddVertex();
+}
 
-                if (!bus->is_roundtrip) {
-                    double time_to_from = CalcDistanceAndGetTime(stops[j], stops[j - 1], distance_to_from);
-                    graph_.AddEdge({ stop_to_id + 1, stop_from_id, time_to_from, bus->name, std::abs(i - j) });
-                }
-            }
+graph::EdgeId TransportRouter::AddEdge(const graph::Edge<double>& edge, double distance) {
+    edge_distances_.push_back(distance);
+    return graph_.AddEdge(edge);
+}
 
-            if (bus->is_roundtrip) {
-                double total_time = CalculateTime(distance_from_to);
-                graph_.AddEdge({ stop_from_id + 1, stop_from_id, total_time, bus->name, static_cast<int>(size) });
-            }
+std::optional<graph::EdgeId> TransportRouter::AddStopVertexes(StopId stop) {
+    const graph::VertexId id_stop = AddVertex({ stop });
+    stops_vertexes_[stop] = id_stop;
+    if (graph_model_ == GraphModel::LINEAR) {
+        return std::nullopt;
+    }
+    AddVertex({ stop, graph::NO_BUS, VertexType::BOARDING });
+    return AddEdge({ id_stop, id_stop + 1, static_cast<double>(settings_.bus_wait_time) }, 0.0);
+}
+
+void TransportRouter::AddRideVertexes(const Bus* bus) {
+    const auto& stops = bus->route;
+    const size_t size = GetDirectionSize(bus);
+    ride_vertexes_[bus->id] = graph_.GetVertexCount();
+    for (size_t i = 0; i < size; ++i) {
+        AddVertex({ stops[i], bus->id, VertexType::RIDE });
+    }
+    if (!bus->is_roundtrip) {
+        for (size_t i = 0; i < size; ++i) {
+            AddVertex({ stops[size - 1 - i], bus->id, VertexType::RIDE });
         }
     }
 }
 
 void TransportRouter::BuildRouter() {
-    graph::VertexId vertex = 0;
-    const auto& buses = catalogue_.GetBuses();
+    raptor_ = std::make_unique<RaptorRouter>(catalogue_);
+    AddProfiles();
+    if (settings_.engine == RouterEngine::RAPTOR) {
+        return;
+    }
 
-    for (const auto& [bus_name, bus] : buses) {
-        for (const auto& stop : bus->route) {
-            unique_stops_.emplace(stop);
+    const auto buses = catalogue_.GetBuses();
+
+    // Stop vertexes are numbered in the order of stop ids
+    std::vector<bool> has_buses(catalogue_.GetStopCount(), false);
+    for (const Bus* bus : buses) {
+        for (const StopId stop : bus->route) {
+            has_buses[stop] = true;
         }
     }
 
-    graph_ = graph::DirectedWeightedGraph<double>(unique_stops_.size() * 2);
+    graph_ = graph::DirectedWeightedGraph<double>();
+    stops_vertexes_.assign(catalogue_.GetStopCount(), NO_VERTEX);
+    ride_vertexes_.assign(catalogue_.GetBusCount(), NO_VERTEX);
+    bus_edges_.assign(catalogue_.GetBusCount(), {});
 
-    for (const auto& stop : unique_stops_) {
-        stops_vertexes_.insert({ stop, vertex });
-        stops_by_vertexes_.push_back(stop);
-        vertex += 2;
-        graph::VertexId id_stop = GetVertexByStop(stop);
-        graph_.AddEdge({ id_stop, id_stop + 1, static_cast<double>(settings_.bus_wait_time), "", 0 });
+    for (StopId stop = 0; stop < has_buses.size(); ++stop) {
+        if (has_buses[stop]) {
+            AddStopVertexes(stop);
+        }
     }
 
     AddBuses(buses);
+    FreezeGraph();
+    MakeProfileGraphs();
+
+    for (auto& [name, profile] : profiles_) {
+        profile.router = MakeRouter(profile);
+    }
+}
+
+void TransportRouter::AddProfiles() {
+    RouteSettings settings = settings_;
+    settings.profiles.clear();
+    profiles_[""].settings = settings;
+    for (const auto& [name, weights] : settings_.profiles) {
+        if (name.empty()) {
+            throw std::invalid_argument("Routing profile name must not be empty");
+        }
+        settings.bus_wait_time = weights.bus_wait_time;
+        settings.bus_velocity = weights.bus_velocity;
+        profiles_[name].settings = settings;
+    }
+}
+
+bool TransportRouter::HasProfile(std::string_view profile) const {
+    return profiles_.find(profile) != profiles_.end();
+}
+
+const TransportRouter::Profile& TransportRouter::GetProfile(std::string_view profile) const {
+    auto it = profiles_.find(profile);
+    if (it == profiles_.end()) {
+        throw std::out_of_range("Unknown routing profile: " + std::string(profile));
+    }
+    return it->second;
+}
+
+const graph::DirectedWeightedGraph<double>& TransportRouter::GetProfileGraph(const Profile& profile) const {
+    return profile.graph ? *profile.graph : graph_;
+}
 
-    router_ = std::make_unique<graph::Router<double>>(graph_);
+void TransportRouter::FreezeGraph() {
+    // The default profile weighs graph_ itself, the others reweight its arcs. Assigned in place, the engines keep references
+    Profile& default_profile = profiles_.at("");
+    default_profile.frozen_graph = graph::FrozenGraph<double>(graph_);
+    for (auto& [name, profile] : profiles_) {
+        if (!name.empty()) {
+            const auto get_weight = [this, &profile](graph::EdgeId edge_id) { return GetEdgeWeight(profile.settings, edge_id); };
+            profile.frozen_graph = default_profile.frozen_graph.Reweight(get_weight);
+        }
+    }
+}
+
+void TransportRouter::MakeProfileGraphs() {
+    if (IsFrozenGraphEngine(settings_.engine)) {
+        return;
+    }
+    for (auto& [name, profile] : profiles_) {
+        if (name.empty()) {
+            continue;
+        }
+        profile.graph = std::make_unique<graph::DirectedWeightedGraph<double>>(graph_);
+        for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+            profile.graph->SetEdgeWeight(edge_id, GetEdgeWeight(profile.settings, edge_id));
+        }
+    }
+}
+
+void TransportRouter::AddBus(const Bus* bus) {
+    Update({ {}, {}, { bus } });
+}
+
+void TransportRouter::RemoveBus(const Bus* bus) {
+    Update({ {}, { bus }, {} });
+}
+
+void TransportRouter::UpdateDistance(const Stop* from, const Stop* to) {
+    Update({ { { from, to } }, {}, {} });
+}
+
+void TransportRouter::Update(const Changes& changes) {
+    const auto distance_buses = GetDistanceBuses(changes);
+    // The patterns of RAPTOR are ordered by the names of the buses, so a new bus can not simply be appended
+    if (changes.removed_buses.empty() && changes.added_buses.empty()) {
+        raptor_->UpdateDistances(distance_buses);
+    }
+    else {
+        raptor_ = std::make_unique<RaptorRouter>(catalogue_);
+    }
+    if (settings_.engine == RouterEngine::RAPTOR) {
+        return;
+    }
+
+    // The stops and the buses may be newer than the router
+    stops_vertexes_.resize(catalogue_.GetStopCount(), NO_VERTEX);
+    ride_vertexes_.resize(catalogue_.GetBusCount(), NO_VERTEX);
+    bus_edges_.resize(catalogue_.GetBusCount());
+
+    const size_t vertex_count = graph_.GetVertexCount();
+    const size_t edge_count = graph_.GetEdgeCount();
+    EdgeChanges edge_changes;
+    std::vector<graph::EdgeId> removed_edges;
+    std::vector<graph::EdgeId> reweighted_edges;
+    for (const Bus* bus : changes.removed_buses) {
+        RemoveBusEdges(bus, removed_edges);
+    }
+    edge_changes.increased = removed_edges;
+    UpdateBusDistances(distance_buses, edge_changes, reweighted_edges);
+    for (const Bus* bus : changes.added_buses) {
+        AddBusEdges(bus, edge_changes);
+    }
+
+    PatchProfileGraphs(vertex_count, edge_count, removed_edges, reweighted_edges);
+    for (auto& [name, profile] : profiles_) {
+        if (!profile.router->Update(edge_changes)) {
+            profile.router = MakeRouter(profile);
+        }
+    }
+}
+
+std::vector<BusId> TransportRouter::GetDistanceBuses(const Changes& changes) const {
+    // SetDistance may change both directions, every bus riding between the stops passes through both of them
+    const auto is_name_less = [this](BusId lhs, BusId rhs) { return catalogue_.GetBus(lhs).name < catalogue_.GetBus(rhs).name; };
+    std::vector<BusId> buses;
+    for (const auto& [from, to] : changes.distances) {
+        const auto from_buses = catalogue_.GetStopBuses(from->id);
+        const auto to_buses = catalogue_.GetStopBuses(to->id);
+        std::set_intersection(from_buses.begin(), from_buses.end(), to_buses.begin(), to_buses.end(), std::back_inserter(buses), is_name_less);
+    }
+    std::sort(buses.begin(), buses.end());
+    buses.erase(std::unique(buses.begin(), buses.end()), buses.end());
+    return buses;
+}
+
+void TransportRouter::RemoveBusEdges(const Bus* bus, std::vector<graph::EdgeId>& removed_edges) {
+    if (bus->id >= bus_edges_.size()) {
+        return;
+    }
+    for (const auto edge_id : bus_edges_[bus->id]) {
+        graph_.RemoveEdge(edge_id);
+        removed_edges.push_back(edge_id);
+    }
+    bus_edges_[bus->id].clear();
+
+    // The ride vertexes stay, but they no longer stand for the bus, which may be added again under the same name
+    if (const graph::VertexId first_ride_vertex = ride_vertexes_[bus->id]; first_ride_vertex != NO_VERTEX) {
+        const size_t ride_vertex_count = bus->is_roundtrip ? GetDirectionSize(bus) : 2 * GetDirectionSize(bus);
+        for (size_t i = 0; i < ride_vertex_count; ++i) {
+            vertexes_[first_ride_vertex + i].bus = graph::NO_BUS;
+        }
+        ride_vertexes_[bus->id] = NO_VERTEX;
+    }
+}
+
+void TransportRouter::UpdateBusDistances(const std::vector<BusId>& buses, EdgeChanges& changes, std::vector<graph::EdgeId>& reweighted_edges) {
+    for (const BusId bus_id : buses) {
+        // The buses added in the batch get their edges with the new distances
+        const auto& edge_ids = bus_edges_[bus_id];
+        if (edge_ids.empty()) {
+            continue;
+        }
+        // Every bus is made once, so an edge is classified by its distance before the batch and after it.
+        // The weights of every profile grow with the distance, so the changes are the same for all of them
+        const auto edges = MakeBusEdges(&catalogue_.GetBus(bus_id));
+        for (size_t i = 0; i < edges.size(); ++i) {
+            double& distance = edge_distances_[edge_ids[i]];
+            if (edges[i].distance == distance) {
+                continue;
+            }
+            (edges[i].distance > distance ? changes.increased : changes.decreased).push_back(edge_ids[i]);
+            reweighted_edges.push_back(edge_ids[i]);
+            graph_.SetEdgeWeight(edge_ids[i], edges[i].edge.weight);
+            distance = edges[i].distance;
+        }
+    }
+}
+
+void TransportRouter::AddBusEdges(const Bus* bus, EdgeChanges& changes) {
+    for (const StopId stop : bus->route) {
+        if (stops_vertexes_[stop] == NO_VERTEX) {
+            if (const auto wait_edge = AddStopVertexes(stop)) {
+                changes.decreased.push_back(*wait_edge);
+            }
+        }
+    }
+    if (graph_model_ == GraphModel::LINEAR) {
+        AddRideVertexes(bus);
+    }
+
+    auto& edge_ids = bus_edges_[bus->id];
+    for (const auto& [edge, distance] : MakeBusEdges(bus)) {
+        edge_ids.push_back(AddEdge(edge, distance));
+        changes.decreased.push_back(edge_ids.back());
+    }
+}
+
+void TransportRouter::PatchProfileGraphs(size_t vertex_count, size_t edge_count, const std::vector<graph::EdgeId>& removed_edges,
+                                         const std::vector<graph::EdgeId>& reweighted_edges) {
+    // The edge lists are patched edge by edge like graph_, the engines keep references to them
+    for (auto& [name, profile] : profiles_) {
+        if (!profile.graph) {
+            continue;
+        }
+        for (size_t vertex = vertex_count; vertex < graph_.GetVertexCount(); ++vertex) {
+            profile.graph->AddVertex();
+        }
+        for (graph::EdgeId edge_id = edge_count; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+            auto edge = graph_.GetEdge(edge_id);
+            edge.weight = GetEdgeWeight(profile.settings, edge_id);
+            profile.graph->AddEdge(edge);
+        }
+        for (const auto edge_id : removed_edges) {
+            profile.graph->RemoveEdge(edge_id);
+        }
+        for (const auto edge_id : reweighted_edges) {
+            profile.graph->SetEdgeWeight(edge_id, GetEdgeWeight(profile.settings, edge_id));
+        }
+    }
+
+    // The arcs of a frozen graph lie in rows, so an added or removed edge means freezing it again, once per batch
+    if (vertex_count != graph_.GetVertexCount() || edge_count != graph_.GetEdgeCount() || !removed_edges.empty()) {
+        FreezeGraph();
+        return;
+    }
+    for (auto& [name, profile] : profiles_) {
+        for (const auto edge_id : reweighted_edges) {
+            profile.frozen_graph.SetEdgeWeight(edge_id, name.empty() ? graph_.GetEdge(edge_id).weight : GetEdgeWeight(profile.settings, edge_id));
+        }
+    }
+}
+
+std::unique_ptr<graph::RouterBase<double>> TransportRouter::MakeRouter(const Profile& profile) const {
+    switch (settings_.engine) {
+    case RouterEngine::DIJKSTRA:
+        return std::make_unique<graph::DijkstraRouter<double>>(profile.frozen_graph);
+    case RouterEngine::CONTRACTION_HIERARCHIES:
+        return std::make_unique<graph::ContractionHierarchy<double>>(GetProfileGraph(profile));
+    case RouterEngine::TILED_FLOYD_WARSHALL:
+        return std::make_unique<graph::TiledRouter<double>>(GetProfileGraph(profile), settings_.thread_count);
+    case RouterEngine::ALT:
+        return std::make_unique<graph::AltRouter<double>>(profile.frozen_graph, graph::AltRouter<double>::DEFAULT_LANDMARK_COUNT,
+                                                          MakeGeoLowerBound(profile));
+    case RouterEngine::FLOYD_WARSHALL:
+    default:
+        return std::make_unique<graph::Router<double>>(GetProfileGraph(profile));
+    }
 }
 
-std::vector<RouteItems> TransportRouter::FindRoute(std::string stop_from, std::string stop_to) const {
-    auto stop_from_id = GetVertexByStop(catalogue_.FindStop(stop_from));
-    auto stop_to_id = GetVertexByStop(catalogue_.FindStop(stop_to));
+graph::AltRouter<double>::LowerBound TransportRouter::MakeGeoLowerBound(const Profile& profile) const {
+    // Rounding errors of the distance formula must not make the bound exceed the real time
+    static const double slack = 1.0 - 1e-9;
+    const auto geo_time = [this, &settings = profile.settings](graph::VertexId from, graph::VertexId to) {
+        const auto distance = geo::ComputeDistance(GetStopByVertex(from)->coordinates, GetStopByVertex(to)->coordinates);
+        return CalculateTime(settings, distance) * slack;
+    };
+
+    // The straight line is a lower bound only if no edge is faster than it, road distances are not checked anywhere else
+    const auto& graph = profile.frozen_graph;
+    for (graph::VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+        for (const auto arc : graph.GetArcs(vertex)) {
+            if (graph.GetWeight(arc) < geo_time(vertex, graph.GetTarget(arc))) {
+                return nullptr;
+            }
+        }
+    }
+    return geo_time;
+}
+
+std::vector<RouteItems> TransportRouter::FindRoute(std::string_view stop_from, std::string_view stop_to, std::string_view profile_name) const {
+    const Profile& profile = GetProfile(profile_name);
+    if (settings_.engine == RouterEngine::RAPTOR) {
+        auto items = raptor_->FindRoute(catalogue_.FindStop(stop_from), catalogue_.FindStop(stop_to), profile.settings);
+        if (!items.has_value()) {
+            return { { "error_message", "", 0, 0 } };
+        }
+        return *items;
+    }
+
+    auto stop_from_id = GetVertexByName(stop_from);
+    auto stop_to_id = GetVertexByName(stop_to);
     std::vector<RouteItems> items;
-    auto result_route = router_->BuildRoute(stop_from_id, stop_to_id);
+    auto result_route = profile.router->BuildRoute(stop_from_id, stop_to_id);
 
     if (!result_route.has_value()) {
         items.push_back({ "error_message", "", 0, 0 });
         return items;
     }
 
-    auto result = result_route.value();
-    
-    for (int i = 0; i < result.edges.size(); ++i) {
-        const auto& edge = graph_.GetEdge(result_route->edges[i]);
+    return MakeRouteItems(*result_route, profile.settings);
+}
+
+RouteItemsMatrix TransportRouter::FindRoutes(const std::vector<std::string>& stops_from, const std::vector<std::string>& stops_to,
+                                             std::string_view profile_name) const {
+    const Profile& profile = GetProfile(profile_name);
+    if (settings_.engine == RouterEngine::RAPTOR) {
+        return FindRaptorRoutes(stops_from, stops_to, profile.settings);
+    }
+
+    // Stops without buses have no vertexes, their routes stay empty
+    const auto collect_vertexes = [this](const std::vector<std::string>& stops, std::vector<graph::VertexId>& vertexes) {
+        std::vector<std::optional<size_t>> indexes;
+        for (const auto& stop : stops) {
+            const Stop* found = catalogue_.FindStop(stop);
+            if (found != nullptr && found->id < stops_vertexes_.size() && stops_vertexes_[found->id] != NO_VERTEX) {
+                indexes.push_back(vertexes.size());
+                vertexes.push_back(stops_vertexes_[found->id]);
+            }
+            else {
+                indexes.push_back(std::nullopt);
+            }
+        }
+        return indexes;
+    };
+
+    std::vector<graph::VertexId> sources, targets;
+    const auto source_indexes = collect_vertexes(stops_from, sources);
+    const auto target_indexes = collect_vertexes(stops_to, targets);
+    const auto routes = profile.router->BuildRoutes(sources, targets);
+    RouteItemsMatrix result(stops_from.size(), std::vector<std::optional<std::vector<RouteItems>>>(stops_to.size()));
 
-        if (edge.from % 2 == 0) {
-            auto stop = GetStopByVertex(edge.from);
-            items.push_back({ "Wait", stop->name, edge.weight });
+    for (size_t i = 0; i < stops_from.size(); ++i) {
+        for (size_t j = 0; j < stops_to.size(); ++j) {
+            if (source_indexes[i] && target_indexes[j]) {
+                const auto& route = routes[*source_indexes[i]][*target_indexes[j]];
+                if (route.has_value()) {
+                    result[i][j] = MakeRouteItems(*route, profile.settings);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<std::vector<RouteItems>> TransportRouter::FindAlternativeRoutes(std::string_view stop_from, std::string_view stop_to, size_t count,
+                                                                            std::string_view profile_name) const {
+    const Profile& profile = GetProfile(profile_name);
+    std::vector<std::vector<RouteItems>> result;
+    if (settings_.engine == RouterEngine::RAPTOR) {
+        auto items = raptor_->FindRoute(catalogue_.FindStop(stop_from), catalogue_.FindStop(stop_to), profile.settings);
+        if (items.has_value() && count > 0) {
+            result.push_back(std::move(*items));
+        }
+        return result;
+    }
+
+    // A bus passing the same stops twice makes parallel edges or ride vertexes, and the routes over them
+    // differ only as paths of the graph. A rider sees the same trip, so it is given once
+    graph::KShortestPaths<double> paths(profile.frozen_graph, GetVertexByName(stop_to));
+    paths.BuildRoutes(GetVertexByName(stop_from), count, [&](const graph::RouterBase<double>::RouteInfo& route) {
+        auto items = MakeRouteItems(route, profile.settings);
+        if (std::any_of(result.begin(), result.end(), [&items](const auto& accepted) { return IsSameTrip(accepted, items); })) {
+            return false;
+        }
+        result.push_back(std::move(items));
+        return true;
+    });
+    return result;
+}
+
+std::vector<std::vector<RouteItems>> TransportRouter::FindParetoRoutes(std::string_view stop_from, std::string_view stop_to,
+                                                                       std::string_view profile_name) const {
+    return raptor_->FindParetoRoutes(catalogue_.FindStop(stop_from), catalogue_.FindStop(stop_to), GetProfile(profile_name).settings);
+}
+
+std::vector<ReachableStop> TransportRouter::FindReachableStops(std::string_view stop_from, double max_time, std::string_view profile_name) const {
+    const Profile& profile = GetProfile(profile_name);
+    std::vector<ReachableStop> result;
+    if (settings_.engine == RouterEngine::RAPTOR) {
+        for (const auto& [stop, time] : raptor_->FindReachableStops(catalogue_.FindStop(stop_from), max_time, profile.settings)) {
+            result.push_back({ stop->name, time });
+        }
+    }
+    else {
+        const auto reached = graph::FindReachableVertexes(profile.frozen_graph, GetVertexByName(stop_from), max_time);
+        for (const auto& [vertex, time] : reached) {
+            // A stop is reached when its stop vertex is, the other vertexes are only passed through
+            if (vertexes_[vertex].type == VertexType::STOP) {
+                result.push_back({ GetStopByVertex(vertex)->name, time });
+            }
         }
+    }
+
+    std::sort(result.begin(), result.end(), [](const ReachableStop& lhs, const ReachableStop& rhs) {
+        return std::tie(lhs.time, lhs.name) < std::tie(rhs.time, rhs.name);
+    });
+    return result;
+}
 
-        auto bus = catalogue_.FindBus(edge.name);
+RouteItemsMatrix TransportRouter::FindRaptorRoutes(const std::vector<std::string>& stops_from, const std::vector<std::string>& stops_to,
+                                                   const RouteSettings& settings) const {
+    std::vector<const Stop*> targets;
+    for (const auto& stop : stops_to) {
+        targets.push_back(catalogue_.FindStop(stop));
+    }
+
+    RouteItemsMatrix result;
+    for (const auto& stop : stops_from) {
+        result.push_back(raptor_->FindRoutes(catalogue_.FindStop(stop), targets, settings));
+    }
+    return result;
+}
 
-        if (bus != nullptr) {
-            items.push_back({ "Bus", bus->name, edge.weight, edge.span_count });
+std::vector<RouteItems> TransportRouter::MakeRouteItems(const graph::RouterBase<double>::RouteInfo& route, const RouteSettings& settings) const {
+    std::vector<RouteItems> items;
+    // A ride of the linear model runs from boarding to getting off over the ride vertexes of one bus
+    double ride_time = 0.0;
+    int span_count = 0;
+
+    for (const auto edge_id : route.edges) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        const auto& from = vertexes_[edge.from];
+        const double weight = GetEdgeWeight(settings, edge_id);
+
+        if (from.type == VertexType::STOP) {
+            items.push_back({ "Wait", catalogue_.GetStop(from.stop).name, weight });
+        }
+        else if (from.type == VertexType::BOARDING) {
+            items.push_back({ "Bus", catalogue_.GetBus(edge.bus_id).name, weight, edge.span_count });
+        }
+        else {
+            ride_time += weight;
+            if (vertexes_[edge.to].type == VertexType::RIDE) {
+                ++span_count;
+            }
+            else {
+                items.push_back({ "Bus", catalogue_.GetBus(from.bus).name, ride_time, span_count });
+                ride_time = 0.0;
+                span_count = 0;
+            }
         }
     }
     return items;
 }
 
-graph::VertexId TransportRouter::GetVertexByStop(const Stop* name) const {
-    auto it = stops_vertexes_.find(name);
-    if (it != stops_vertexes_.end()) {
-        return it->second;
+bool TransportRouter::IsSnapshotEngine(RouterEngine engine) {
+    return engine == RouterEngine::FLOYD_WARSHALL || engine == RouterEngine::DIJKSTRA;
+}
+
+void TransportRouter::SaveSnapshot(const std::filesystem::path& path) const {
+    if (!IsSnapshotEngine(settings_.engine)) {
+        throw std::logic_error("The snapshot does not keep the data of this routing engine");
+    }
+
+    snapshot::RouterData data;
+    data.fingerprint = ComputeFingerprint();
+
+    // Bus ids are the indexes in bus_names. A removed bus has no name, its name may belong to a bus added again
+    for (BusId bus_id = 0; bus_id < catalogue_.GetBusCount(); ++bus_id) {
+        const Bus& bus = catalogue_.GetBus(bus_id);
+        data.bus_names.push_back(catalogue_.FindBus(bus.name) == &bus ? std::string_view(bus.name) : std::string_view());
+    }
+    const auto to_record_bus = [](graph::BusId bus_id) {
+        return bus_id == graph::NO_BUS ? snapshot::NO_BUS : bus_id;
+    };
+
+    // Stops are written in the order of their first vertexes, the ids of the catalogue are not kept
+    constexpr uint32_t NO_INDEX = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> stop_indexes(catalogue_.GetStopCount(), NO_INDEX);
+    for (const auto& vertex : vertexes_) {
+        if (stop_indexes[vertex.stop] == NO_INDEX) {
+            stop_indexes[vertex.stop] = static_cast<uint32_t>(data.stop_names.size());
+            data.stop_names.push_back(catalogue_.GetStop(vertex.stop).name);
+        }
+        data.vertexes.push_back({ stop_indexes[vertex.stop], to_record_bus(vertex.bus), static_cast<uint32_t>(vertex.type) });
+    }
+
+    // Edges missing from the incidence lists were removed by RemoveBus
+    std::vector<bool> is_attached(graph_.GetEdgeCount(), false);
+    for (graph::VertexId vertex = 0; vertex < graph_.GetVertexCount(); ++vertex) {
+        for (const auto edge_id : graph_.GetIncidentEdges(vertex)) {
+            is_attached[edge_id] = true;
+        }
+    }
+
+    for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        data.edges.push_back({ static_cast<uint32_t>(edge.from), static_cast<uint32_t>(edge.to), edge.weight, edge_distances_[edge_id],
+                               to_record_bus(edge.bus_id), edge.span_count, is_attached[edge_id] ? 0u : 1u });
+    }
+
+    if (settings_.engine == RouterEngine::FLOYD_WARSHALL) {
+        for (const auto& [name, profile] : profiles_) {
+            const auto& router = dynamic_cast<const graph::Router<double>&>(*profile.router);
+            data.routes.push_back(std::as_bytes(router.GetRoutesInternalData()));
+        }
+        data.routes_cell_size = sizeof(graph::Router<double>::RouteInternalData);
+    }
+    snapshot::Save(path, data);
+}
+
+std::unique_ptr<TransportRouter> TransportRouter::FromSnapshot(const transport_catalogue::TransportCatalogue& catalogue, RouteSettings settings,
+                                                               const std::filesystem::path& path) {
+    if (!IsSnapshotEngine(settings.engine)) {
+        return nullptr;
+    }
+    auto snapshot = snapshot::MappedSnapshot::Open(path);
+    if (!snapshot) {
+        return nullptr;
+    }
+
+    std::unique_ptr<TransportRouter> router(new TransportRouter(catalogue, settings, std::move(snapshot)));
+    if (!router->RestoreFromSnapshot()) {
+        return nullptr;
+    }
+    router->raptor_ = std::make_unique<RaptorRouter>(catalogue);
+    return router;
+}
+
+bool TransportRouter::RestoreFromSnapshot() {
+    const auto& data = snapshot_->GetData();
+    if (data.fingerprint != ComputeFingerprint()) {
+        return false;
+    }
+    AddProfiles();
+
+    std::vector<StopId> stops;
+    for (const auto name : data.stop_names) {
+        const Stop* stop = catalogue_.FindStop(name);
+        if (stop == nullptr) {
+            return false;
+        }
+        stops.push_back(stop->id);
+    }
+
+    // The saved ids become the ids of the catalogue, a bus that is no longer there has none
+    std::vector<BusId> buses;
+    for (const auto name : data.bus_names) {
+        const Bus* bus = name.empty() ? nullptr : catalogue_.FindBus(name);
+        buses.push_back(bus != nullptr ? bus->id : graph::NO_BUS);
+    }
+    const auto to_bus_id = [&buses](uint32_t record_bus) {
+        return record_bus != snapshot::NO_BUS ? buses[record_bus] : graph::NO_BUS;
+    };
+
+    stops_vertexes_.assign(catalogue_.GetStopCount(), NO_VERTEX);
+    ride_vertexes_.assign(catalogue_.GetBusCount(), NO_VERTEX);
+    bus_edges_.assign(catalogue_.GetBusCount(), {});
+
+    for (const auto& record : data.vertexes) {
+        if (record.stop >= stops.size() || (record.bus != snapshot::NO_BUS && record.bus >= buses.size())
+            || record.type > static_cast<uint32_t>(VertexType::RIDE)) {
+            return false;
+        }
+        const StopId stop = stops[record.stop];
+        const BusId bus = to_bus_id(record.bus);
+        const auto type = static_cast<VertexType>(record.type);
+        const graph::VertexId vertex = AddVertex({ stop, bus, type });
+
+        if (type == VertexType::STOP) {
+            stops_vertexes_[stop] = vertex;
+        }
+        else if (bus != graph::NO_BUS && ride_vertexes_[bus] == NO_VERTEX) {
+            // The first ride vertex of a bus comes first
+            ride_vertexes_[bus] = vertex;
+        }
+    }
+
+    for (const auto& record : data.edges) {
+        if (record.from >= graph_.GetVertexCount() || record.to >= graph_.GetVertexCount()
+            || (record.bus != snapshot::NO_BUS && record.bus >= buses.size())) {
+            return false;
+        }
+        const graph::BusId bus_id = to_bus_id(record.bus);
+        BusId bus = bus_id;
+        // Edges of the linear model carry no bus, they belong to the bus of their ride vertex
+        for (const auto vertex : { record.from, record.to }) {
+            if (vertexes_[vertex].type == VertexType::RIDE) {
+                bus = vertexes_[vertex].bus;
+            }
+        }
+        const auto edge_id = AddEdge({ record.from, record.to, record.weight, bus_id, record.span_count }, record.distance);
+
+        if (record.is_removed) {
+            graph_.RemoveEdge(edge_id);
+        }
+        else if (bus != graph::NO_BUS) {
+            bus_edges_[bus].push_back(edge_id);
+        }
+        else if (record.bus != snapshot::NO_BUS) {
+            return false;
+        }
+    }
+
+    FreezeGraph();
+    MakeProfileGraphs();
+
+    // Every profile has its table in the file, in the order of the names like profiles_
+    using RouteInternalData = graph::Router<double>::RouteInternalData;
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (settings_.engine == RouterEngine::FLOYD_WARSHALL) {
+        if (data.routes.size() != profiles_.size() || data.routes_cell_size != sizeof(RouteInternalData)) {
+            return false;
+        }
+        auto routes = data.routes.begin();
+        for (auto& [name, profile] : profiles_) {
+            if (routes->size() != vertex_count * vertex_count * sizeof(RouteInternalData)) {
+                return false;
+            }
+            const auto* cells = reinterpret_cast<const RouteInternalData*>(routes->data());
+            profile.router = std::make_unique<graph::Router<double>>(GetProfileGraph(profile), std::span(cells, vertex_count * vertex_count));
+            ++routes;
+        }
+    }
+    else {
+        // Dijkstra keeps nothing but the graph
+        for (auto& [name, profile] : profiles_) {
+            profile.router = MakeRouter(profile);
+        }
+    }
+    return true;
+}
+
+uint64_t TransportRouter::ComputeFingerprint() const {
+    // FNV-1a over everything the graph and the tables are built from: the settings with the engine and the profiles,
+    // the routes of the buses and their road distances
+    uint64_t hash = 14695981039346656037ull;
+    const auto add = [&hash](const void* data, size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+    const auto add_name = [&add](std::string_view name) {
+        const auto size = name.size();
+        add(&size, sizeof(size));
+        add(name.data(), name.size());
+    };
+
+    add(&settings_.bus_wait_time, sizeof(settings_.bus_wait_time));
+    add(&settings_.bus_velocity, sizeof(settings_.bus_velocity));
+    add(&settings_.engine, sizeof(settings_.engine));
+    add(&graph_model_, sizeof(graph_model_));
+    // The tables of the profiles lie in the file in the order of their names
+    const auto profile_count = settings_.profiles.size();
+    add(&profile_count, sizeof(profile_count));
+    for (const auto& [name, weights] : settings_.profiles) {
+        add_name(name);
+        add(&weights.bus_wait_time, sizeof(weights.bus_wait_time));
+        add(&weights.bus_velocity, sizeof(weights.bus_velocity));
+    }
+
+    std::vector<const Bus*> buses = catalogue_.GetBuses();
+    std::sort(buses.begin(), buses.end(), [](const Bus* lhs, const Bus* rhs) { return lhs->name < rhs->name; });
+
+    for (const auto bus : buses) {
+        add_name(bus->name);
+        add(&bus->is_roundtrip, sizeof(bus->is_roundtrip));
+        for (size_t i = 0; i < bus->route.size(); ++i) {
+            add_name(catalogue_.GetStop(bus->route[i]).name);
+            if (i > 0) {
+                const int distances[] = { catalogue_.GetDistance(bus->route[i - 1], bus->route[i]),
+                                          catalogue_.GetDistance(bus->route[i], bus->route[i - 1]) };
+                add(distances, sizeof(distances));
+            }
+        }
+    }
+    return hash;
+}
+
+RouterStats TransportRouter::GetStats() const {
+    if (settings_.engine == RouterEngine::RAPTOR) {
+        return { 0, 0, raptor_->GetMemoryUsage() };
+    }
+    size_t router_memory = 0;
+    for (const auto& [name, profile] : profiles_) {
+        router_memory += profile.router->GetMemoryUsage();
+    }
+    return { graph_.GetVertexCount(), graph_.GetEdgeCount(), router_memory };
+}
+
+graph::VertexId TransportRouter::GetVertexByStop(StopId stop) const {
+    if (stop < stops_vertexes_.size() && stops_vertexes_[stop] != NO_VERTEX) {
+        return stops_vertexes_[stop];
     }
     else {
-        throw std::out_of_range("Out of range unordered map stops!");
+        throw std::out_of_range("Out of range vector stops!");
     }
 }
 
+graph::VertexId TransportRouter::GetVertexByName(std::string_view stop) const {
+    const Stop* found = catalogue_.FindStop(stop);
+    if (found == nullptr) {
+        throw std::out_of_range("Unknown stop: " + std::string(stop));
+    }
+    return GetVertexByStop(found->id);
+}
+
 const Stop* TransportRouter::GetStopByVertex(graph::VertexId id) const {
-    auto index = static_cast<size_t>(id) / 2;
-    if (index < stops_by_vertexes_.size()) {
-        return stops_by_vertexes_.at(index);
+    if (id < vertexes_.size()) {
+        return &catalogue_.GetStop(vertexes_[id].stop);
     }
     else {
         throw std::out_of_range("Out of range vector stops!");
     }
 }
 
+double TransportRouter::CalculateTime(const RouteSettings& settings, double distance) {
+    return distance / settings.bus_velocity / 1000.0 * 60.0;
+}
+
 double TransportRouter::CalculateTime(double distance) const {
-    return distance / settings_.bus_velocity / 1000.0 * 60.0;
+    return CalculateTime(settings_, distance);
+}
+
+double TransportRouter::GetEdgeWeight(const RouteSettings& settings, graph::EdgeId edge_id) const {
+    // Every edge leaving a stop vertex is the wait for a bus, the others are rides
+    if (vertexes_[graph_.GetEdge(edge_id).from].type == VertexType::STOP) {
+        return static_cast<double>(settings.bus_wait_time);
+    }
+    return CalculateTime(settings, edge_distances_[edge_id]);
 }
\ No newline at end of file
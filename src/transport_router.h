@@ -1,41 +1,206 @@
 #pragma once
 
+#include "alt_router.h"
+#include "bounded_search.h"
+#include "contraction_hierarchy.h"
+#include "dijkstra_router.h"
+#include "frozen_graph.h"
 #include "graph.h"
+#include "k_shortest_paths.h"
+#include "raptor_router.h"
 #include "router.h"
+#include "router_snapshot.h"
+#include "tiled_router.h"
 #include "transport_catalogue.h"
 
+#include<filesystem>
+#include<limits>
+#include<map>
 #include<memory>
+#include<optional>
+#include<string_view>
+#include<utility>
+#include<vector>
 
-struct RouteItems {
-    std::string_view type;
-    std::string_view name;
-    double time;
-    int span_count = 0;
+// items[i][j] is the route from the i-th stop to the j-th one, empty if there is none
+using RouteItemsMatrix = std::vector<std::vector<std::optional<std::vector<RouteItems>>>>;
+
+struct RouterStats {
+    size_t vertex_count = 0;
+    size_t edge_count = 0;
+    // Bytes kept by the routing engine between queries
+    size_t router_memory = 0;
 };
 
-struct RouteSettings {
-    int bus_wait_time = 0;
-    double bus_velocity = 0.0;
+struct ReachableStop {
+    std::string_view name;
+    double time = 0.0;
 };
 
+// Every stop has a stop vertex where routes start and end. The complete model adds a boarding vertex
+// behind the wait edge of the stop and an edge from it to every later stop of every bus. The linear model
+// boards a bus by an edge into its ride vertex at the stop, the ride vertexes of a bus are linked stop by stop
+// and an edge of zero weight leads back to the stop vertex; the bus and the stop count of a ride are restored
+// from the ride vertexes when the route is unpacked.
+// The routing profiles share the vertexes, the edges and their road distances. Every profile weighs them
+// with its own wait time and velocity and keeps its own engine data; queries name the profile, the default one is empty
 class TransportRouter {
 public:
     TransportRouter(const transport_catalogue::TransportCatalogue& catalogue, RouteSettings settings);
-    std::vector<RouteItems> FindRoute(std::string stop_from, std::string stop_to) const;
+    bool HasProfile(std::string_view profile) const;
+    std::vector<RouteItems> FindRoute(std::string_view stop_from, std::string_view stop_to, std::string_view profile = {}) const;
+    RouteItemsMatrix FindRoutes(const std::vector<std::string>& stops_from, const std::vector<std::string>& stops_to,
+                                std::string_view profile = {}) const;
+    // Up to count loopless routes in the order of time, the first one is the fastest; empty if there is none.
+    // RAPTOR keeps no graph and gives only the fastest route
+    std::vector<std::vector<RouteItems>> FindAlternativeRoutes(std::string_view stop_from, std::string_view stop_to, size_t count,
+                                                               std::string_view profile = {}) const;
+    // Routes trading time for fewer buses: see RaptorRouter::FindParetoRoutes. Any engine answers it with RAPTOR
+    std::vector<std::vector<RouteItems>> FindParetoRoutes(std::string_view stop_from, std::string_view stop_to,
+                                                          std::string_view profile = {}) const;
+    // Every stop reachable within max_time minutes, the source included, in the order of time and then name
+    std::vector<ReachableStop> FindReachableStops(std::string_view stop_from, double max_time, std::string_view profile = {}) const;
+    // The graph and the engine data of all profiles
+    RouterStats GetStats() const;
+
+    // What changed in the catalogue since the router was built or last updated
+    struct Changes {
+        // The stops of every TransportCatalogue::SetDistance(from, to, ...)
+        std::vector<std::pair<const Stop*, const Stop*>> distances;
+        // Buses the router knows that are removed from the catalogue
+        std::vector<const Bus*> removed_buses;
+        // Buses added to the catalogue and still there
+        std::vector<const Bus*> added_buses;
+    };
+
+    // The catalogue is changed first, then the router is told what changed, once for the whole batch.
+    // Only the edges of the affected buses are patched, in graph_ and in the edge lists of the profiles;
+    // the frozen graphs are frozen again only if edges were added or removed, otherwise their weights are
+    // patched too. RAPTOR gets the new distances in place and is built again if buses were added or removed.
+    // Every engine is asked to repair its data once: Floyd-Warshall, tiled or not, always can, Dijkstra keeps
+    // none, ALT keeps its landmarks while no edge gets lighter. Contraction hierarchies are built again
+    void Update(const Changes& changes);
+    // Batches of one change
+    void AddBus(const Bus* bus);
+    void RemoveBus(const Bus* bus);
+    void UpdateDistance(const Stop* from, const Stop* to);
+
+    // Engines whose data a snapshot keeps: the Floyd-Warshall tables, and Dijkstra, which needs only the graph.
+    // The others are always built, their preprocessing is not saved
+    static bool IsSnapshotEngine(RouterEngine engine);
+    // Writes the graph and the Floyd-Warshall tables of all profiles into a versioned binary file.
+    // Throws std::logic_error for an engine that is not IsSnapshotEngine
+    void SaveSnapshot(const std::filesystem::path& path) const;
+    // Restores the router from a snapshot without rebuilding it. nullptr if there is no usable snapshot:
+    // the engine is not IsSnapshotEngine, the file is missing, has another format version or was built
+    // from another catalogue or settings, the engine and the profiles included
+    static std::unique_ptr<TransportRouter> FromSnapshot(const transport_catalogue::TransportCatalogue& catalogue, RouteSettings settings,
+                                                         const std::filesystem::path& path);
 
 private:
+    TransportRouter(const transport_catalogue::TransportCatalogue& catalogue, RouteSettings settings, std::unique_ptr<snapshot::MappedSnapshot> snapshot);
+    bool RestoreFromSnapshot();
+    uint64_t ComputeFingerprint() const;
+    using EdgeChanges = graph::RouterBase<double>::EdgeChanges;
+
+    enum class VertexType : uint32_t {
+        STOP,
+        // Complete model: the wait is over, any bus of the stop can be boarded
+        BOARDING,
+        // Linear model: on board of the bus at the stop
+        RIDE,
+    };
+
+    struct VertexInfo {
+        StopId stop = 0;
+        // Only for a ride vertex; reset when the bus is removed
+        BusId bus = graph::NO_BUS;
+        VertexType type = VertexType::STOP;
+    };
+
+    // An edge of a bus with the road distance its weight is made from
+    struct BusEdge {
+        graph::Edge<double> edge;
+        double distance = 0.0;
+    };
+
+    struct Profile {
+        // The settings of the router with the wait time and the velocity of the profile
+        RouteSettings settings;
+        // A weighted copy of the edges for the engines that do not search the frozen graph, patched together with graph_;
+        // the default profile uses graph_
+        std::unique_ptr<graph::DirectedWeightedGraph<double>> graph;
+        // Shares its arcs with the frozen graphs of the other profiles
+        graph::FrozenGraph<double> frozen_graph;
+        std::unique_ptr<graph::RouterBase<double>> router;
+    };
+
+    // Engines that search the frozen graph and need no edge list of their own
+    static bool IsFrozenGraphEngine(RouterEngine engine);
+    // Stops a bus passes in one direction: the whole route of a roundtrip bus, half of the there-and-back one
+    static size_t GetDirectionSize(const Bus* bus);
+    static constexpr graph::VertexId NO_VERTEX = std::numeric_limits<graph::VertexId>::max();
+
     void BuildRouter();
-    graph::VertexId GetVertexByStop(const Stop* name) const;
+    // The default profile and the named ones, without their engine data
+    void AddProfiles();
+    // Throws std::out_of_range for an unknown profile
+    const Profile& GetProfile(std::string_view profile) const;
+    const graph::DirectedWeightedGraph<double>& GetProfileGraph(const Profile& profile) const;
+    // Freezes graph_ into the frozen graphs of the profiles
+    void FreezeGraph();
+    // Copies graph_ into the edge lists of the named profiles, with their weights
+    void MakeProfileGraphs();
+    std::unique_ptr<graph::RouterBase<double>> MakeRouter(const Profile& profile) const;
+    RouteItemsMatrix FindRaptorRoutes(const std::vector<std::string>& stops_from, const std::vector<std::string>& stops_to,
+                                      const RouteSettings& settings) const;
+    graph::AltRouter<double>::LowerBound MakeGeoLowerBound(const Profile& profile) const;
+    std::vector<RouteItems> MakeRouteItems(const graph::RouterBase<double>::RouteInfo& route, const RouteSettings& settings) const;
+    graph::VertexId GetVertexByStop(StopId stop) const;
+    // Throws std::out_of_range for an unknown stop, as for a stop without buses
+    graph::VertexId GetVertexByName(std::string_view stop) const;
     const Stop* GetStopByVertex(graph::VertexId id) const;
+    static double CalculateTime(const RouteSettings& settings, double distance);
     double CalculateTime(double distance) const;
-    double CalcDistanceAndGetTime(const Stop* from, const Stop* to, double& distance);
-    void AddBuses(const std::unordered_map<std::string_view, const Bus*>& buses);
+    double CalcDistanceAndGetTime(StopId from, StopId to, double& distance) const;
+    // The weight of the edge in the profile with these settings
+    double GetEdgeWeight(const RouteSettings& settings, graph::EdgeId edge_id) const;
+    graph::VertexId AddVertex(const VertexInfo& info);
+    graph::EdgeId AddEdge(const graph::Edge<double>& edge, double distance);
+    // The wait edge of the stop, the linear model has none
+    std::optional<graph::EdgeId> AddStopVertexes(StopId stop);
+    void AddRideVertexes(const Bus* bus);
+    std::vector<BusEdge> MakeBusEdges(const Bus* bus) const;
+    std::vector<BusEdge> MakeCompleteBusEdges(const Bus* bus) const;
+    std::vector<BusEdge> MakeLinearBusEdges(const Bus* bus) const;
+    void AddBuses(const std::vector<const Bus*>& ordered_buses);
+    // The buses riding between the stops of the changed distances, by id
+    std::vector<BusId> GetDistanceBuses(const Changes& changes) const;
+    void RemoveBusEdges(const Bus* bus, std::vector<graph::EdgeId>& removed_edges);
+    void UpdateBusDistances(const std::vector<BusId>& buses, EdgeChanges& changes, std::vector<graph::EdgeId>& reweighted_edges);
+    void AddBusEdges(const Bus* bus, EdgeChanges& changes);
+    // Brings the edge lists and the frozen graphs of the profiles up to graph_, which had vertex_count vertexes
+    // and edge_count edges before the batch
+    void PatchProfileGraphs(size_t vertex_count, size_t edge_count, const std::vector<graph::EdgeId>& removed_edges,
+                            const std::vector<graph::EdgeId>& reweighted_edges);
 
     const transport_catalogue::TransportCatalogue& catalogue_;
+    // Declared before profiles_, whose default router may use the mapped table
+    std::unique_ptr<snapshot::MappedSnapshot> snapshot_;
+    // Built and patched edge by edge with the weights of the default profile; the searches that run per query read its frozen copies
     graph::DirectedWeightedGraph<double> graph_;
-    std::unique_ptr<graph::Router<double>> router_;
-    std::unordered_set<const Stop*> unique_stops_;
-    std::unordered_map<const Stop*, graph::VertexId> stops_vertexes_;
-    std::vector<const Stop*> stops_by_vertexes_;
+    // Road distances of the edges by id, 0 for a wait
+    std::vector<double> edge_distances_;
+    std::map<std::string, Profile, std::less<>> profiles_;
+    // Built for every engine: it answers Pareto queries, and all queries for RouterEngine::RAPTOR, which builds no graph
+    std::unique_ptr<RaptorRouter> raptor_;
+    // The stop vertex by StopId, NO_VERTEX for the stops no bus passes
+    std::vector<graph::VertexId> stops_vertexes_;
+    std::vector<VertexInfo> vertexes_;
+    // The first ride vertex by BusId: the forward stops of the bus go in a row, then the backward ones
+    std::vector<graph::VertexId> ride_vertexes_;
+    // Edges by BusId in the order MakeBusEdges produces them; the edges carry the catalogue ids of the buses
+    std::vector<std::vector<graph::EdgeId>> bus_edges_;
     RouteSettings settings_;
+    GraphModel graph_model_;
 };
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "versioned_catalogue.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace transport_catalogue {
+
+VersionedCatalogue::Editor::Editor(TransportCatalogue& catalogue)
+    : catalogue_(catalogue) {
+}
+
+void VersionedCatalogue::Editor::AddStop(std::string_view name, geo::Coordinates coordinates) {
+    catalogue_.AddStop(name, coordinates);
+    changes_.stops.push_back(static_cast<StopId>(catalogue_.GetStopCount() - 1));
+}
+
+void VersionedCatalogue::Editor::AddBus(std::string_view name, const std::vector<std::string_view>& data, bool is_roundtrip) {
+    catalogue_.AddBus(name, data, is_roundtrip);
+    const Bus& bus = catalogue_.GetBus(static_cast<BusId>(catalogue_.GetBusCount() - 1));
+    changes_.buses.push_back(bus.id);
+    // The stops of the route get the bus
+    changes_.stops.insert(changes_.stops.end(), bus.route.begin(), bus.route.end());
+}
+
+void VersionedCatalogue::Editor::RemoveBus(std::string_view name) {
+    const Bus* bus = catalogue_.FindBus(name);
+    if (bus == nullptr) {
+        return;
+    }
+    catalogue_.RemoveBus(name);
+    changes_.buses.push_back(bus->id);
+    changes_.stops.insert(changes_.stops.end(), bus->route.begin(), bus->route.end());
+}
+
+void VersionedCatalogue::Editor::SetDistance(StopId stop_from, StopId stop_to, int distance) {
+    catalogue_.SetDistance(stop_from, stop_to, distance);
+    // The way back may be set as well
+    changes_.stops.push_back(stop_from);
+    changes_.stops.push_back(stop_to);
+    // Any bus driving between the two stops, in either direction, passes stop_from
+    const auto buses = catalogue_.GetStopBuses(stop_from);
+    changes_.buses.insert(changes_.buses.end(), buses.begin(), buses.end());
+}
+
+const TransportCatalogue& VersionedCatalogue::Editor::GetCatalogue() const {
+    return catalogue_;
+}
+
+VersionedCatalogue::Pinned::Pinned(const VersionedCatalogue* owner, Version* version)
+    : owner_(owner), version_(version) {
+}
+
+VersionedCatalogue::Pinned::Pinned(Pinned&& other) noexcept
+    : owner_(std::exchange(other.owner_, nullptr)), version_(std::exchange(other.version_, nullptr)) {
+}
+
+VersionedCatalogue::Pinned& VersionedCatalogue::Pinned::operator=(Pinned&& other) noexcept {
+    if (this != &other) {
+        if (version_ != nullptr) {
+            owner_->Release(version_);
+        }
+        owner_ = std::exchange(other.owner_, nullptr);
+        version_ = std::exchange(other.version_, nullptr);
+    }
+    return *this;
+}
+
+VersionedCatalogue::Pinned::~Pinned() {
+    if (version_ != nullptr) {
+        owner_->Release(version_);
+    }
+}
+
+const FrozenCatalogue& VersionedCatalogue::Pinned::operator*() const {
+    return version_->catalogue;
+}
+
+const FrozenCatalogue* VersionedCatalogue::Pinned::operator->() const {
+    return &version_->catalogue;
+}
+
+VersionedCatalogue::Version::Version(FrozenCatalogue frozen)
+    : catalogue(std::move(frozen)) {
+}
+
+VersionedCatalogue::VersionedCatalogue(TransportCatalogue& catalogue)
+    : catalogue_(catalogue), current_(Pack(new Version(FrozenCatalogue(catalogue)))) {
+}
+
+VersionedCatalogue::~VersionedCatalogue() {
+    delete GetVersion(current_.load(std::memory_order_acquire));
+}
+
+uint64_t VersionedCatalogue::Pack(Version* version) {
+    const auto address = reinterpret_cast<uintptr_t>(version);
+    if ((address & ~POINTER_MASK) != 0) {
+        delete version;
+        throw std::runtime_error("Address of the catalogue version does not fit in 48 bits");
+    }
+    return address;
+}
+
+VersionedCatalogue::Version* VersionedCatalogue::GetVersion(uint64_t word) {
+    return reinterpret_cast<Version*>(static_cast<uintptr_t>(word & POINTER_MASK));
+}
+
+uint64_t VersionedCatalogue::GetReaderCount(uint64_t word) {
+    return word >> POINTER_BITS;
+}
+
+VersionedCatalogue::Pinned VersionedCatalogue::Pin() const {
+    uint64_t word = current_.load(std::memory_order_relaxed);
+    do {
+        if (GetReaderCount(word) == MAX_READERS) {
+            throw std::overflow_error("Too many readers of the catalogue version");
+        }
+    } while (!current_.compare_exchange_weak(word, word + ONE_READER, std::memory_order_acquire, std::memory_order_relaxed));
+    return Pinned(this, GetVersion(word));
+}
+
+void VersionedCatalogue::Release(Version* version) const {
+    // While the version is current, its reader is counted in the word
+    uint64_t word = current_.load(std::memory_order_relaxed);
+    while (GetVersion(word) == version) {
+        if (current_.compare_exchange_weak(word, word - ONE_READER, std::memory_order_release, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+    // Otherwise the publisher has handed it over, or is about to; the version cannot be freed before
+    // this reader lets it go, so its address is not reused meanwhile
+    if (version->reader_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete version;
+    }
+}
+
+void VersionedCatalogue::Update(const std::function<void(Editor&)>& edit) {
+    std::lock_guard lock(write_mutex_);
+    Editor editor(catalogue_);
+    editor.changes_ = std::move(pending_changes_);
+    pending_changes_ = {};
+    try {
+        edit(editor);
+    }
+    catch (...) {
+        pending_changes_ = std::move(editor.changes_);
+        throw;
+    }
+    Publish(editor.changes_);
+}
+
+void VersionedCatalogue::Publish(const FrozenCatalogue::Changes& changes) {
+    if (changes.stops.empty() && changes.buses.empty()) {
+        return;
+    }
+    // Only writers replace the version, and they hold write_mutex_, so the previous one stays until the exchange
+    Version* previous = GetVersion(current_.load(std::memory_order_acquire));
+    const uint64_t next = Pack(new Version(FrozenCatalogue(catalogue_, previous->catalogue, changes)));
+
+    const uint64_t replaced = current_.exchange(next, std::memory_order_acq_rel);
+    // The readers that already let it go have taken themselves off the count
+    const auto reader_count = static_cast<int64_t>(GetReaderCount(replaced));
+    if (previous->reader_count.fetch_add(reader_count, std::memory_order_acq_rel) == -reader_count) {
+        delete previous;
+    }
+}
+
+}  // namespace transport_catalogue
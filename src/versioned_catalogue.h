@@ -0,0 +1,110 @@
+#pragma once
+
+#include "frozen_catalogue.h"
+#include "transport_catalogue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+
+// Serves a catalogue that keeps changing to readers on other threads. Readers pin the current version,
+// an immutable FrozenCatalogue, and query it for as long as they like. Writers change the catalogue and
+// publish the next version with one atomic exchange, so a reader never waits for an update to be prepared;
+// the next version shares the chunks the update did not touch with the previous one.
+// Pinning and letting go are lock-free: the pointer to the current version and the count of its readers
+// share one 64-bit word, changed by compare-and-swap. A publisher hands the count of the replaced version
+// over to the version itself, and whoever brings it to zero, the last reader or the publisher, frees it.
+// From then on the catalogue must be changed only by Update. Everything else reading the catalogue itself,
+// such as TransportRouter, must not run during an Update and has to be told of the changes as before
+class VersionedCatalogue {
+    struct Version;
+
+public:
+    // Records what the changes touch, so the next version copies only that
+    class Editor {
+    public:
+        void AddStop(std::string_view name, geo::Coordinates coordinates);
+        void AddBus(std::string_view name, const std::vector<std::string_view>& data, bool is_roundtrip);
+        void RemoveBus(std::string_view name);
+        void SetDistance(StopId stop_from, StopId stop_to, int distance);
+        // The catalogue with the changes made so far
+        const TransportCatalogue& GetCatalogue() const;
+
+    private:
+        friend class VersionedCatalogue;
+        explicit Editor(TransportCatalogue& catalogue);
+
+        TransportCatalogue& catalogue_;
+        FrozenCatalogue::Changes changes_;
+    };
+
+    // A pinned version. It does not change while it is held, whatever is published after it;
+    // it has to be let go before the VersionedCatalogue is destroyed
+    class Pinned {
+    public:
+        Pinned(Pinned&& other) noexcept;
+        Pinned& operator=(Pinned&& other) noexcept;
+        ~Pinned();
+
+        const FrozenCatalogue& operator*() const;
+        const FrozenCatalogue* operator->() const;
+
+    private:
+        friend class VersionedCatalogue;
+        Pinned(const VersionedCatalogue* owner, Version* version);
+
+        const VersionedCatalogue* owner_ = nullptr;
+        Version* version_ = nullptr;
+    };
+
+    // Publishes the catalogue as the first version
+    explicit VersionedCatalogue(TransportCatalogue& catalogue);
+    VersionedCatalogue(const VersionedCatalogue&) = delete;
+    VersionedCatalogue& operator=(const VersionedCatalogue&) = delete;
+    ~VersionedCatalogue();
+
+    // The current version, allocates nothing. Throws std::overflow_error if MAX_READERS readers
+    // already hold it
+    Pinned Pin() const;
+    // Makes the changes and publishes them as one version. Writers wait for each other, readers never do.
+    // If edit throws, nothing is published: the changes it made before stay in the catalogue and go out
+    // with the next version, so an edit checks its input before it changes anything
+    void Update(const std::function<void(Editor&)>& edit);
+
+    static constexpr uint64_t MAX_READERS = (uint64_t{1} << 16) - 1;
+
+private:
+    struct Version {
+        explicit Version(FrozenCatalogue frozen);
+
+        FrozenCatalogue catalogue;
+        // The readers handed over by the publisher that replaced the version, less the ones that let it go
+        // since it was replaced
+        std::atomic<int64_t> reader_count{0};
+    };
+
+    // The pointer in the low 48 bits, the count of its readers in the high 16
+    static constexpr int POINTER_BITS = 48;
+    static constexpr uint64_t POINTER_MASK = (uint64_t{1} << POINTER_BITS) - 1;
+    static constexpr uint64_t ONE_READER = uint64_t{1} << POINTER_BITS;
+
+    static uint64_t Pack(Version* version);
+    static Version* GetVersion(uint64_t word);
+    static uint64_t GetReaderCount(uint64_t word);
+
+    void Release(Version* version) const;
+    void Publish(const FrozenCatalogue::Changes& changes);
+
+    TransportCatalogue& catalogue_;
+    std::mutex write_mutex_;
+    // Made by an edit that threw, not published yet
+    FrozenCatalogue::Changes pending_changes_;
+    mutable std::atomic<uint64_t> current_;
+};
+
+}  // namespace transport_catalogue
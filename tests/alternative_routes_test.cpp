@@ -0,0 +1,144 @@
+#include "testing.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+using transport_catalogue::TransportCatalogue;
+
+namespace {
+
+const RouterEngine GRAPH_ENGINES[] = { RouterEngine::FLOYD_WARSHALL, RouterEngine::TILED_FLOYD_WARSHALL, RouterEngine::DIJKSTRA,
+                                       RouterEngine::CONTRACTION_HIERARCHIES, RouterEngine::ALT };
+const GraphModel GRAPH_MODELS[] = { GraphModel::COMPLETE, GraphModel::LINEAR };
+
+RouteSettings MakeSettings(RouterEngine engine, GraphModel model) {
+    RouteSettings settings;
+    settings.bus_wait_time = 2;
+    settings.bus_velocity = 30.0;
+    settings.engine = engine;
+    settings.graph_model = model;
+    return settings;
+}
+
+double GetTotalTime(const std::vector<RouteItems>& items) {
+    double total_time = 0.0;
+    for (const auto& item : items) {
+        total_time += item.time;
+    }
+    return total_time;
+}
+
+// The routes are distinct trips in the order of time, the first one is the route FindRoute gives
+void CheckAlternatives(const TransportRouter& router, std::string_view from, std::string_view to, size_t count) {
+    const auto routes = router.FindAlternativeRoutes(from, to, count);
+    CHECK(routes.size() <= count);
+    for (size_t i = 0; i < routes.size(); ++i) {
+        for (size_t j = 0; j < i; ++j) {
+            CHECK(!IsSameTrip(routes[i], routes[j]));
+        }
+        if (i > 0) {
+            CHECK(GetTotalTime(routes[i - 1]) <= GetTotalTime(routes[i]) + 1e-9);
+        }
+    }
+    if (!routes.empty()) {
+        CHECK(std::abs(GetTotalTime(routes.front()) - GetTotalTime(router.FindRoute(from, to))) < 1e-9);
+    }
+}
+
+// Times that differ only by the rounding of their sums are the same trip, other steps are not
+void TestSameTripUpToRounding() {
+    const std::vector<RouteItems> trip = { { "Wait", "S1", 2.0, 0 }, { "Bus", "1", 0.1 + 0.2 + 0.3, 3 } };
+    CHECK(IsSameTrip(trip, { { "Wait", "S1", 2.0, 0 }, { "Bus", "1", 0.3 + 0.2 + 0.1, 3 } }));
+    CHECK(!IsSameTrip(trip, { { "Wait", "S1", 2.0, 0 }, { "Bus", "1", 0.6001, 3 } }));
+    CHECK(!IsSameTrip(trip, { { "Wait", "S1", 2.0, 0 }, { "Bus", "1", 0.6, 2 } }));
+    CHECK(!IsSameTrip(trip, { { "Wait", "S1", 2.0, 0 }, { "Bus", "2", 0.6, 3 } }));
+    CHECK(!IsSameTrip(trip, { { "Wait", "S1", 2.0, 0 } }));
+}
+
+// The there-and-back bus rides S1 -> S2 twice: there and on the way back, after turning at the second S1
+void TestBusPassingStopsTwice() {
+    TransportCatalogue catalogue;
+    catalogue.AddStop("S1", { 55.60, 37.60 });
+    catalogue.AddStop("S2", { 55.61, 37.61 });
+    catalogue.AddStop("S4", { 55.62, 37.59 });
+    const auto s1 = catalogue.FindStop("S1")->id;
+    const auto s2 = catalogue.FindStop("S2")->id;
+    const auto s4 = catalogue.FindStop("S4")->id;
+    catalogue.SetDistance(s1, s2, 1000);
+    catalogue.SetDistance(s1, s4, 1500);
+    catalogue.AddBus("B1", { "S4", "S1", "S2", "S1", "S2", "S1", "S4" }, false);
+    catalogue.Finalize();
+
+    for (const auto engine : GRAPH_ENGINES) {
+        for (const auto model : GRAPH_MODELS) {
+            const TransportRouter router(catalogue, MakeSettings(engine, model));
+            const auto routes = router.FindAlternativeRoutes("S1", "S2", 5);
+            // Straight there, and the two ways through the turn at S4
+            CHECK(routes.size() == 3);
+            CHECK(routes.size() > 0 && routes[0].size() == 2 && routes[0][1].name == "B1" && routes[0][1].span_count == 1);
+            CheckAlternatives(router, "S1", "S2", 5);
+        }
+    }
+}
+
+void TestRandomNetworks() {
+    std::mt19937 generator(42);
+    for (int network = 0; network < 20; ++network) {
+        TransportCatalogue catalogue;
+        const int stop_count = 8;
+        std::vector<std::string> stop_names;
+        for (int i = 0; i < stop_count; ++i) {
+            stop_names.push_back("S" + std::to_string(i));
+            catalogue.AddStop(stop_names.back(), { 55.0 + std::uniform_real_distribution<>(0, 0.05)(generator),
+                                                   37.0 + std::uniform_real_distribution<>(0, 0.05)(generator) });
+        }
+        for (int i = 0; i < stop_count * 2; ++i) {
+            const auto from = generator() % stop_count;
+            const auto to = generator() % stop_count;
+            catalogue.SetDistance(from, to, 500 + generator() % 3000);
+        }
+        // Short random routes over few stops pass the same pairs of stops again and again
+        std::vector<std::string> bus_names;
+        for (int bus = 0; bus < 4; ++bus) {
+            std::vector<std::string_view> stops;
+            const size_t size = 3 + generator() % 4;
+            for (size_t i = 0; i < size; ++i) {
+                stops.push_back(stop_names[generator() % stop_count]);
+            }
+            const bool is_roundtrip = generator() % 2 == 0;
+            if (is_roundtrip) {
+                stops.push_back(stops.front());
+            }
+            else {
+                stops.insert(stops.end(), stops.rbegin() + 1, stops.rend());
+            }
+            bus_names.push_back("B" + std::to_string(bus));
+            catalogue.AddBus(bus_names.back(), stops, is_roundtrip);
+        }
+        catalogue.Finalize();
+
+        for (const auto model : GRAPH_MODELS) {
+            const TransportRouter router(catalogue, MakeSettings(RouterEngine::DIJKSTRA, model));
+            for (const auto& from : stop_names) {
+                for (const auto& to : stop_names) {
+                    if (!catalogue.GetStopInfo(from).empty() && !catalogue.GetStopInfo(to).empty()) {
+                        CheckAlternatives(router, from, to, 6);
+                    }
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    TestSameTripUpToRounding();
+    TestBusPassingStopsTwice();
+    TestRandomNetworks();
+    return testing::Finish();
+}
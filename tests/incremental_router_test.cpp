@@ -0,0 +1,179 @@
+#include "testing.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+using transport_catalogue::TransportCatalogue;
+
+namespace {
+
+const RouterEngine ENGINES[] = { RouterEngine::FLOYD_WARSHALL, RouterEngine::TILED_FLOYD_WARSHALL, RouterEngine::DIJKSTRA,
+                                 RouterEngine::CONTRACTION_HIERARCHIES, RouterEngine::ALT, RouterEngine::RAPTOR };
+const GraphModel GRAPH_MODELS[] = { GraphModel::COMPLETE, GraphModel::LINEAR };
+const int STOP_COUNT = 30;
+const int STEP_COUNT = 20;
+
+double GetTotalTime(const std::vector<RouteItems>& items) {
+    double total_time = 0.0;
+    for (const auto& item : items) {
+        total_time += item.time;
+    }
+    return total_time;
+}
+
+void AddRandomBus(TransportCatalogue& catalogue, const std::string& name, std::mt19937& generator) {
+    std::vector<std::string_view> stops;
+    const size_t size = 2 + generator() % 6;
+    for (size_t i = 0; i < size; ++i) {
+        stops.push_back(catalogue.GetStop(generator() % STOP_COUNT).name);
+    }
+    // Stored the way JsonReader stores them: a roundtrip ends where it starts, the other buses go there and back
+    const bool is_roundtrip = generator() % 2 == 0;
+    if (is_roundtrip) {
+        stops.push_back(stops.front());
+    }
+    else {
+        stops.insert(stops.end(), stops.rbegin() + 1, stops.rend());
+    }
+    catalogue.AddBus(name, stops, is_roundtrip);
+}
+
+// Every route of the patched router, for the default and the named profile, takes as long as the route of a router
+// built from scratch. The tables keep float weights, hence the tolerance
+void CheckSameRoutes(const TransportCatalogue& catalogue, const TransportRouter& patched, const RouteSettings& settings) {
+    const TransportRouter fresh(catalogue, settings);
+    for (StopId from = 0; from < STOP_COUNT; ++from) {
+        for (StopId to = 0; to < STOP_COUNT; ++to) {
+            const auto from_name = catalogue.GetStop(from).name;
+            const auto to_name = catalogue.GetStop(to).name;
+            if (catalogue.GetStopInfo(from_name).empty() || catalogue.GetStopInfo(to_name).empty()) {
+                continue;
+            }
+            for (const std::string_view profile : { std::string_view{}, std::string_view{"fast"} }) {
+                const double patched_time = GetTotalTime(patched.FindRoute(from_name, to_name, profile));
+                const double fresh_time = GetTotalTime(fresh.FindRoute(from_name, to_name, profile));
+                CHECK(std::abs(patched_time - fresh_time) <= 1e-4 * std::max(1.0, fresh_time));
+            }
+        }
+    }
+}
+
+void TestRandomChanges(RouterEngine engine, GraphModel model) {
+    std::mt19937 generator(7);
+    TransportCatalogue catalogue;
+    for (int i = 0; i < STOP_COUNT; ++i) {
+        catalogue.AddStop("S" + std::to_string(i), { 55.0 + std::uniform_real_distribution<>(0, 0.05)(generator),
+                                                     37.0 + std::uniform_real_distribution<>(0, 0.05)(generator) });
+    }
+    for (int i = 0; i < STOP_COUNT * 2; ++i) {
+        catalogue.SetDistance(generator() % STOP_COUNT, generator() % STOP_COUNT, 500 + generator() % 3000);
+    }
+    int bus_count = 0;
+    for (; bus_count < 8; ++bus_count) {
+        AddRandomBus(catalogue, "B" + std::to_string(bus_count), generator);
+    }
+    catalogue.Finalize();
+
+    RouteSettings settings;
+    settings.bus_wait_time = 6;
+    settings.bus_velocity = 40.0;
+    settings.engine = engine;
+    settings.graph_model = model;
+    settings.profiles["fast"] = RouteProfile{ 2, 70.0 };
+    TransportRouter router(catalogue, settings);
+
+    for (int step = 0; step < STEP_COUNT; ++step) {
+        const auto buses = catalogue.GetBuses();
+        const int change = buses.size() < 3 ? 1 : generator() % 3;
+        if (change == 0) {
+            const Bus* bus = buses[generator() % buses.size()];
+            const size_t i = generator() % (bus->route.size() - 1);
+            catalogue.SetDistance(bus->route[i], bus->route[i + 1], 100 + generator() % 5000);
+            router.UpdateDistance(&catalogue.GetStop(bus->route[i]), &catalogue.GetStop(bus->route[i + 1]));
+        }
+        else if (change == 1) {
+            const std::string name = "B" + std::to_string(bus_count++);
+            AddRandomBus(catalogue, name, generator);
+            router.AddBus(catalogue.FindBus(name));
+        }
+        else {
+            const Bus* bus = buses[generator() % buses.size()];
+            catalogue.RemoveBus(bus->name);
+            router.RemoveBus(bus);
+        }
+        CheckSameRoutes(catalogue, router, settings);
+    }
+}
+
+// Several changes of every kind go to the router in one Update, the way an Update request sends them
+void TestRandomBatches(RouterEngine engine, GraphModel model) {
+    std::mt19937 generator(13);
+    TransportCatalogue catalogue;
+    for (int i = 0; i < STOP_COUNT; ++i) {
+        catalogue.AddStop("S" + std::to_string(i), { 55.0 + std::uniform_real_distribution<>(0, 0.05)(generator),
+                                                     37.0 + std::uniform_real_distribution<>(0, 0.05)(generator) });
+    }
+    for (int i = 0; i < STOP_COUNT * 2; ++i) {
+        catalogue.SetDistance(generator() % STOP_COUNT, generator() % STOP_COUNT, 500 + generator() % 3000);
+    }
+    int bus_count = 0;
+    for (; bus_count < 8; ++bus_count) {
+        AddRandomBus(catalogue, "B" + std::to_string(bus_count), generator);
+    }
+    catalogue.Finalize();
+
+    RouteSettings settings;
+    settings.bus_wait_time = 6;
+    settings.bus_velocity = 40.0;
+    settings.engine = engine;
+    settings.graph_model = model;
+    settings.profiles["fast"] = RouteProfile{ 2, 70.0 };
+    TransportRouter router(catalogue, settings);
+
+    for (int step = 0; step < STEP_COUNT; ++step) {
+        TransportRouter::Changes changes;
+        // Only the buses the router knows are removed, a bus added in the batch stays till its end
+        std::vector<const Bus*> known_buses = catalogue.GetBuses();
+        const int change_count = 1 + generator() % 4;
+        for (int i = 0; i < change_count; ++i) {
+            const int change = known_buses.size() < 3 ? 1 : generator() % 3;
+            if (change == 0) {
+                const auto buses = catalogue.GetBuses();
+                const Bus* bus = buses[generator() % buses.size()];
+                const size_t j = generator() % (bus->route.size() - 1);
+                catalogue.SetDistance(bus->route[j], bus->route[j + 1], 100 + generator() % 5000);
+                changes.distances.push_back({ &catalogue.GetStop(bus->route[j]), &catalogue.GetStop(bus->route[j + 1]) });
+            }
+            else if (change == 1) {
+                const std::string name = "B" + std::to_string(bus_count++);
+                AddRandomBus(catalogue, name, generator);
+                changes.added_buses.push_back(catalogue.FindBus(name));
+            }
+            else {
+                const size_t j = generator() % known_buses.size();
+                catalogue.RemoveBus(known_buses[j]->name);
+                changes.removed_buses.push_back(known_buses[j]);
+                known_buses.erase(known_buses.begin() + j);
+            }
+        }
+        router.Update(changes);
+        CheckSameRoutes(catalogue, router, settings);
+    }
+}
+
+}  // namespace
+
+int main() {
+    for (const auto engine : ENGINES) {
+        for (const auto model : GRAPH_MODELS) {
+            TestRandomChanges(engine, model);
+            TestRandomBatches(engine, model);
+        }
+    }
+    return testing::Finish();
+}
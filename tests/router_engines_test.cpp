@@ -0,0 +1,223 @@
+#include "testing.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using transport_catalogue::TransportCatalogue;
+
+namespace {
+
+// Every engine answers as the Floyd-Warshall router of the same catalogue and settings
+const RouterEngine ENGINES[] = { RouterEngine::TILED_FLOYD_WARSHALL, RouterEngine::DIJKSTRA, RouterEngine::CONTRACTION_HIERARCHIES,
+                                 RouterEngine::ALT, RouterEngine::RAPTOR };
+const GraphModel GRAPH_MODELS[] = { GraphModel::COMPLETE, GraphModel::LINEAR };
+const std::string_view PROFILES[] = { {}, "fast" };
+const int STOP_COUNT = 30;
+const int BUS_COUNT = 10;
+const unsigned SEEDS[] = { 1, 2, 3 };
+
+double GetTotalTime(const std::vector<RouteItems>& items) {
+    double total_time = 0.0;
+    for (const auto& item : items) {
+        total_time += item.time;
+    }
+    return total_time;
+}
+
+bool HasRoute(const std::vector<RouteItems>& items) {
+    return items.empty() || items.front().type != "error_message";
+}
+
+// The tables keep float weights, hence the tolerance
+bool IsSameTime(double lhs, double rhs) {
+    return std::abs(lhs - rhs) <= 1e-4 * std::max(1.0, std::abs(rhs));
+}
+
+// With road distances no shorter than the straight line ALT uses the geographic lower bound, otherwise only the landmarks
+void FillCatalogue(TransportCatalogue& catalogue, unsigned seed, bool is_geographic) {
+    std::mt19937 generator(seed);
+    for (int i = 0; i < STOP_COUNT; ++i) {
+        catalogue.AddStop("S" + std::to_string(i), { 55.0 + std::uniform_real_distribution<>(0, 0.05)(generator),
+                                                     37.0 + std::uniform_real_distribution<>(0, 0.05)(generator) });
+    }
+    for (int i = 0; i < STOP_COUNT * 3; ++i) {
+        const StopId from = generator() % STOP_COUNT;
+        const StopId to = generator() % STOP_COUNT;
+        int distance = 500 + generator() % 3000;
+        if (is_geographic) {
+            distance += static_cast<int>(geo::ComputeDistance(catalogue.GetStop(from).coordinates, catalogue.GetStop(to).coordinates));
+        }
+        catalogue.SetDistance(from, to, distance);
+    }
+    for (int i = 0; i < BUS_COUNT; ++i) {
+        std::vector<std::string_view> stops;
+        const size_t size = 2 + generator() % 7;
+        for (size_t j = 0; j < size; ++j) {
+            stops.push_back(catalogue.GetStop(generator() % STOP_COUNT).name);
+        }
+        // Stored the way JsonReader stores them: a roundtrip ends where it starts, the other buses go there and back
+        const bool is_roundtrip = generator() % 2 == 0;
+        if (is_roundtrip) {
+            stops.push_back(stops.front());
+        }
+        else {
+            stops.insert(stops.end(), stops.rbegin() + 1, stops.rend());
+        }
+        catalogue.AddBus("B" + std::to_string(i), stops, is_roundtrip);
+    }
+    catalogue.Finalize();
+}
+
+RouteSettings MakeSettings(RouterEngine engine, GraphModel model) {
+    RouteSettings settings;
+    settings.bus_wait_time = 6;
+    settings.bus_velocity = 40.0;
+    settings.engine = engine;
+    settings.graph_model = model;
+    settings.profiles["fast"] = RouteProfile{ 2, 70.0 };
+    return settings;
+}
+
+// The stops some bus passes, the others have no vertexes
+std::vector<std::string> GetServedStops(const TransportCatalogue& catalogue) {
+    std::vector<std::string> stops;
+    for (StopId stop = 0; stop < STOP_COUNT; ++stop) {
+        if (!catalogue.GetStopBuses(stop).empty()) {
+            stops.emplace_back(catalogue.GetStop(stop).name);
+        }
+    }
+    return stops;
+}
+
+void CheckRoutes(const std::vector<std::string>& stops, const TransportRouter& baseline, const TransportRouter& router, std::string_view profile) {
+    for (const auto& from : stops) {
+        for (const auto& to : stops) {
+            const auto expected = baseline.FindRoute(from, to, profile);
+            const auto items = router.FindRoute(from, to, profile);
+            CHECK(HasRoute(items) == HasRoute(expected));
+            if (HasRoute(items) && HasRoute(expected)) {
+                CHECK(IsSameTime(GetTotalTime(items), GetTotalTime(expected)));
+            }
+        }
+    }
+}
+
+// The matrix of all served stops with an unserved one on both sides, whose row and column stay empty
+void CheckRouteMatrix(const TransportCatalogue& catalogue, const std::vector<std::string>& stops, const TransportRouter& baseline,
+                      const TransportRouter& router, std::string_view profile) {
+    std::vector<std::string> matrix_stops = stops;
+    for (StopId stop = 0; stop < STOP_COUNT; ++stop) {
+        if (catalogue.GetStopBuses(stop).empty()) {
+            matrix_stops.emplace_back(catalogue.GetStop(stop).name);
+            break;
+        }
+    }
+    const auto matrix = router.FindRoutes(matrix_stops, matrix_stops, profile);
+    CHECK(matrix.size() == matrix_stops.size());
+    for (size_t i = 0; i < matrix.size(); ++i) {
+        CHECK(matrix[i].size() == matrix_stops.size());
+        for (size_t j = 0; j < matrix[i].size(); ++j) {
+            if (i >= stops.size() || j >= stops.size()) {
+                CHECK(!matrix[i][j].has_value());
+                continue;
+            }
+            const auto expected = baseline.FindRoute(stops[i], stops[j], profile);
+            CHECK(matrix[i][j].has_value() == HasRoute(expected));
+            if (matrix[i][j].has_value() && HasRoute(expected)) {
+                CHECK(IsSameTime(GetTotalTime(*matrix[i][j]), GetTotalTime(expected)));
+            }
+        }
+    }
+}
+
+// A stop is reachable if its route is no longer than max_time; the stops within the tolerance of it may go either way
+void CheckReachableStops(const std::vector<std::string>& stops, const TransportRouter& baseline, const TransportRouter& router,
+                         std::string_view profile) {
+    const double max_time = 30.0;
+    for (const auto& from : stops) {
+        const auto reached = router.FindReachableStops(from, max_time, profile);
+        CHECK(std::is_sorted(reached.begin(), reached.end(), [](const ReachableStop& lhs, const ReachableStop& rhs) {
+            return std::tie(lhs.time, lhs.name) < std::tie(rhs.time, rhs.name);
+        }));
+        for (const auto& to : stops) {
+            const auto expected = baseline.FindRoute(from, to, profile);
+            const auto it = std::find_if(reached.begin(), reached.end(), [&to](const ReachableStop& stop) { return stop.name == to; });
+            if (it != reached.end()) {
+                CHECK(it->time <= max_time);
+                CHECK(HasRoute(expected) && IsSameTime(it->time, GetTotalTime(expected)));
+            }
+            else {
+                CHECK(!HasRoute(expected) || GetTotalTime(expected) > max_time || IsSameTime(GetTotalTime(expected), max_time));
+            }
+        }
+    }
+}
+
+size_t GetBusCount(const std::vector<RouteItems>& items) {
+    return std::count_if(items.begin(), items.end(), [](const RouteItems& item) { return item.type == "Bus"; });
+}
+
+// Every next Pareto route takes more buses and less time, the last one is as fast as the fastest route
+void CheckParetoRoutes(const std::vector<std::string>& stops, const TransportRouter& baseline, const TransportRouter& router,
+                       std::string_view profile) {
+    for (const auto& from : stops) {
+        for (const auto& to : stops) {
+            if (from == to) {
+                continue;
+            }
+            const auto expected = baseline.FindRoute(from, to, profile);
+            const auto routes = router.FindParetoRoutes(from, to, profile);
+            CHECK(routes.empty() == !HasRoute(expected));
+            if (routes.empty() || !HasRoute(expected)) {
+                continue;
+            }
+            CHECK(IsSameTime(GetTotalTime(routes.back()), GetTotalTime(expected)));
+            CHECK(GetBusCount(routes.front()) > 0);
+            for (size_t i = 1; i < routes.size(); ++i) {
+                CHECK(GetBusCount(routes[i - 1]) < GetBusCount(routes[i]));
+                CHECK(GetTotalTime(routes[i - 1]) > GetTotalTime(routes[i]));
+            }
+        }
+    }
+}
+
+void TestEngines(unsigned seed, bool is_geographic, GraphModel model) {
+    TransportCatalogue catalogue;
+    FillCatalogue(catalogue, seed, is_geographic);
+    const auto stops = GetServedStops(catalogue);
+    const TransportRouter baseline(catalogue, MakeSettings(RouterEngine::FLOYD_WARSHALL, model));
+
+    for (const auto profile : PROFILES) {
+        CheckRouteMatrix(catalogue, stops, baseline, baseline, profile);
+        CheckReachableStops(stops, baseline, baseline, profile);
+        CheckParetoRoutes(stops, baseline, baseline, profile);
+    }
+    for (const auto engine : ENGINES) {
+        const TransportRouter router(catalogue, MakeSettings(engine, model));
+        for (const auto profile : PROFILES) {
+            CheckRoutes(stops, baseline, router, profile);
+            CheckRouteMatrix(catalogue, stops, baseline, router, profile);
+            CheckReachableStops(stops, baseline, router, profile);
+            CheckParetoRoutes(stops, baseline, router, profile);
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    for (const auto seed : SEEDS) {
+        for (const bool is_geographic : { false, true }) {
+            for (const auto model : GRAPH_MODELS) {
+                TestEngines(seed, is_geographic, model);
+            }
+        }
+    }
+    return testing::Finish();
+}
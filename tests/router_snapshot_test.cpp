@@ -0,0 +1,173 @@
+#include "testing.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using transport_catalogue::TransportCatalogue;
+
+namespace {
+
+const GraphModel GRAPH_MODELS[] = { GraphModel::COMPLETE, GraphModel::LINEAR };
+const int STOP_COUNT = 25;
+const int BUS_COUNT = 8;
+
+std::filesystem::path GetSnapshotPath() {
+    return std::filesystem::temp_directory_path() / "router_snapshot_test.bin";
+}
+
+void FillCatalogue(TransportCatalogue& catalogue) {
+    std::mt19937 generator(11);
+    for (int i = 0; i < STOP_COUNT; ++i) {
+        catalogue.AddStop("S" + std::to_string(i), { 55.0 + std::uniform_real_distribution<>(0, 0.05)(generator),
+                                                     37.0 + std::uniform_real_distribution<>(0, 0.05)(generator) });
+    }
+    for (int i = 0; i < STOP_COUNT * 2; ++i) {
+        catalogue.SetDistance(generator() % STOP_COUNT, generator() % STOP_COUNT, 500 + generator() % 3000);
+    }
+    for (int i = 0; i < BUS_COUNT; ++i) {
+        std::vector<std::string_view> stops;
+        const size_t size = 2 + generator() % 6;
+        for (size_t j = 0; j < size; ++j) {
+            stops.push_back(catalogue.GetStop(generator() % STOP_COUNT).name);
+        }
+        // Stored the way JsonReader stores them: a roundtrip ends where it starts, the other buses go there and back
+        const bool is_roundtrip = generator() % 2 == 0;
+        if (is_roundtrip) {
+            stops.push_back(stops.front());
+        }
+        else {
+            stops.insert(stops.end(), stops.rbegin() + 1, stops.rend());
+        }
+        catalogue.AddBus("B" + std::to_string(i), stops, is_roundtrip);
+    }
+    catalogue.Finalize();
+}
+
+RouteSettings MakeSettings(RouterEngine engine, GraphModel model) {
+    RouteSettings settings;
+    settings.bus_wait_time = 6;
+    settings.bus_velocity = 40.0;
+    settings.engine = engine;
+    settings.graph_model = model;
+    settings.profiles["fast"] = RouteProfile{ 2, 70.0 };
+    settings.profiles["slow"] = RouteProfile{ 10, 25.0 };
+    return settings;
+}
+
+bool IsSameRoute(const std::vector<RouteItems>& lhs, const std::vector<RouteItems>& rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs[i].type != rhs[i].type || lhs[i].name != rhs[i].name || lhs[i].span_count != rhs[i].span_count
+            || lhs[i].time != rhs[i].time) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The restored router answers every route of every profile exactly as the one that was saved
+void CheckSameRoutes(const TransportCatalogue& catalogue, const TransportRouter& saved, const TransportRouter& restored) {
+    for (StopId from = 0; from < STOP_COUNT; ++from) {
+        for (StopId to = 0; to < STOP_COUNT; ++to) {
+            const auto from_name = catalogue.GetStop(from).name;
+            const auto to_name = catalogue.GetStop(to).name;
+            if (catalogue.GetStopInfo(from_name).empty() || catalogue.GetStopInfo(to_name).empty()) {
+                continue;
+            }
+            for (const std::string_view profile : { std::string_view{}, std::string_view{"fast"}, std::string_view{"slow"} }) {
+                CHECK(IsSameRoute(saved.FindRoute(from_name, to_name, profile), restored.FindRoute(from_name, to_name, profile)));
+            }
+        }
+    }
+}
+
+void TestRoundtrip(RouterEngine engine, GraphModel model) {
+    TransportCatalogue catalogue;
+    FillCatalogue(catalogue);
+    const RouteSettings settings = MakeSettings(engine, model);
+    const TransportRouter saved(catalogue, settings);
+    saved.SaveSnapshot(GetSnapshotPath());
+
+    const auto restored = TransportRouter::FromSnapshot(catalogue, settings, GetSnapshotPath());
+    CHECK(restored != nullptr);
+    if (restored) {
+        CheckSameRoutes(catalogue, saved, *restored);
+        CHECK(restored->GetStats().vertex_count == saved.GetStats().vertex_count);
+        CHECK(restored->GetStats().edge_count == saved.GetStats().edge_count);
+    }
+}
+
+// A snapshot of other settings is not used, whatever of them differs
+void TestOtherSettings() {
+    TransportCatalogue catalogue;
+    FillCatalogue(catalogue);
+    const RouteSettings settings = MakeSettings(RouterEngine::FLOYD_WARSHALL, GraphModel::COMPLETE);
+    TransportRouter(catalogue, settings).SaveSnapshot(GetSnapshotPath());
+    CHECK(TransportRouter::FromSnapshot(catalogue, settings, GetSnapshotPath()) != nullptr);
+
+    RouteSettings other_engine = settings;
+    other_engine.engine = RouterEngine::DIJKSTRA;
+    CHECK(TransportRouter::FromSnapshot(catalogue, other_engine, GetSnapshotPath()) == nullptr);
+
+    RouteSettings other_model = settings;
+    other_model.graph_model = GraphModel::LINEAR;
+    CHECK(TransportRouter::FromSnapshot(catalogue, other_model, GetSnapshotPath()) == nullptr);
+
+    RouteSettings other_profile = settings;
+    other_profile.profiles["fast"].bus_velocity = 80.0;
+    CHECK(TransportRouter::FromSnapshot(catalogue, other_profile, GetSnapshotPath()) == nullptr);
+
+    RouteSettings more_profiles = settings;
+    more_profiles.profiles["night"] = RouteProfile{ 20, 30.0 };
+    CHECK(TransportRouter::FromSnapshot(catalogue, more_profiles, GetSnapshotPath()) == nullptr);
+
+    RouteSettings renamed_profile = settings;
+    renamed_profile.profiles.erase("slow");
+    renamed_profile.profiles["lazy"] = settings.profiles.at("slow");
+    CHECK(TransportRouter::FromSnapshot(catalogue, renamed_profile, GetSnapshotPath()) == nullptr);
+}
+
+// The preprocessing of these engines is not kept, they neither write nor read a snapshot
+void TestUnsavedEngines() {
+    TransportCatalogue catalogue;
+    FillCatalogue(catalogue);
+    for (const auto engine : { RouterEngine::TILED_FLOYD_WARSHALL, RouterEngine::CONTRACTION_HIERARCHIES, RouterEngine::ALT,
+                               RouterEngine::RAPTOR }) {
+        const RouteSettings settings = MakeSettings(engine, GraphModel::COMPLETE);
+        CHECK(!TransportRouter::IsSnapshotEngine(engine));
+
+        bool is_refused = false;
+        try {
+            TransportRouter(catalogue, settings).SaveSnapshot(GetSnapshotPath());
+        }
+        catch (const std::logic_error&) {
+            is_refused = true;
+        }
+        CHECK(is_refused);
+
+        // Not even a snapshot of the same graph is taken
+        TransportRouter(catalogue, MakeSettings(RouterEngine::DIJKSTRA, GraphModel::COMPLETE)).SaveSnapshot(GetSnapshotPath());
+        CHECK(TransportRouter::FromSnapshot(catalogue, settings, GetSnapshotPath()) == nullptr);
+    }
+}
+
+}  // namespace
+
+int main() {
+    for (const auto engine : { RouterEngine::FLOYD_WARSHALL, RouterEngine::DIJKSTRA }) {
+        for (const auto model : GRAPH_MODELS) {
+            TestRoundtrip(engine, model);
+        }
+    }
+    TestOtherSettings();
+    TestUnsavedEngines();
+    std::filesystem::remove(GetSnapshotPath());
+    return testing::Finish();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <iostream>
+#include <string_view>
+
+// Bare checks for the test programs: a failed check prints where it is and fails the program at the end
+namespace testing {
+
+inline int& GetFailureCount() {
+    static int failure_count = 0;
+    return failure_count;
+}
+
+inline void ReportFailure(std::string_view expression, std::string_view file, int line) {
+    std::cerr << file << ':' << line << ": check failed: " << expression << std::endl;
+    ++GetFailureCount();
+}
+
+// The exit code of the test program
+inline int Finish() {
+    if (GetFailureCount() > 0) {
+        std::cerr << GetFailureCount() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+}  // namespace testing
+
+#define CHECK(expression)                                                     \
+    do {                                                                      \
+        if (!(expression)) {                                                  \
+            ::testing::ReportFailure(#expression, __FILE__, __LINE__);        \
+        }                                                                     \
+    } while (false)
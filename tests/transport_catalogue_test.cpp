@@ -0,0 +1,238 @@
+#include "testing.h"
+#include "transport_catalogue.h"
+#include "versioned_catalogue.h"
+
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using transport_catalogue::FrozenCatalogue;
+using transport_catalogue::TransportCatalogue;
+using transport_catalogue::VersionedCatalogue;
+
+namespace {
+
+struct StopData {
+    std::string_view name;
+    geo::Coordinates coordinates;
+    std::map<std::string_view, int> road_distances;
+};
+
+struct BusData {
+    std::string_view name;
+    std::vector<std::string_view> stops;
+    bool is_roundtrip = false;
+};
+
+// Some road distances are set one way only, one from a stop to itself, one pair has none;
+// buses pass stops more than once, names are prefixes of each other and not all of them are ASCII
+const StopData STOPS[] = {
+    { "Tolstopaltsevo", { 55.611087, 37.20829 }, { { "Marushkino", 3900 } } },
+    { "Marushkino", { 55.595884, 37.209755 }, { { "Rasskazovka", 9900 }, { "Marushkino", 100 } } },
+    { "Rasskazovka", { 55.632761, 37.333324 }, { { "Marushkino", 9500 } } },
+    { "Biryulyovo Zapadnoye", { 55.574371, 37.6517 }, { { "Rossoshanskaya ulitsa", 7500 }, { "Biryusinka", 1800 }, { "Universam", 2400 } } },
+    { "Biryusinka", { 55.581065, 37.64839 }, { { "Universam", 750 } } },
+    { "Universam", { 55.587655, 37.645687 }, { { "Rossoshanskaya ulitsa", 5600 }, { "Biryulyovo Tovarnaya", 900 } } },
+    { "Biryulyovo Tovarnaya", { 55.592028, 37.653656 }, { { "Biryulyovo Passazhirskaya", 1300 } } },
+    { "Biryulyovo Passazhirskaya", { 55.580999, 37.659164 }, { { "Biryulyovo Zapadnoye", 1200 } } },
+    { "Rossoshanskaya ulitsa", { 55.595579, 37.605757 }, {} },
+    { "Prazhskaya", { 55.611678, 37.603831 }, {} },
+    { "Улица Лизы Чайкиной", { 55.595, 37.62 }, { { "Biryusinka", 2100 } } },
+    { "Biryu", { 55.59, 37.64 }, {} },
+};
+
+const BusData BUSES[] = {
+    { "256", { "Biryulyovo Zapadnoye", "Biryusinka", "Universam", "Biryulyovo Tovarnaya", "Biryulyovo Passazhirskaya", "Biryulyovo Zapadnoye" }, true },
+    { "750", { "Tolstopaltsevo", "Marushkino", "Marushkino", "Rasskazovka" }, false },
+    { "828", { "Biryulyovo Zapadnoye", "Universam", "Rossoshanskaya ulitsa", "Biryulyovo Zapadnoye" }, true },
+    { "Экспресс", { "Улица Лизы Чайкиной", "Biryusinka", "Universam", "Biryusinka" }, false },
+    { "14", { "Biryu", "Universam", "Biryulyovo Tovarnaya" }, false },
+    { "1", { "Biryusinka", "Улица Лизы Чайкиной", "Biryusinka" }, true },
+};
+
+struct ExpectedBusInfo {
+    std::string_view name;
+    double route_length = 0.0;
+    // Printed with six significant digits
+    double curvature = 0.0;
+    int stop_count = 0;
+    int unique_stop_count = 0;
+};
+
+// The answers of the catalogue before the dense ids, the sorted distance rows, the name arena and Finalize
+const ExpectedBusInfo BASELINE_BUS_INFOS[] = {
+    { "256", 5950, 1.36124, 6, 5 },
+    { "750", 27400, 1.30853, 7, 3 },
+    { "828", 15500, 1.95908, 4, 3 },
+    { "Экспресс", 7200, 0.930854, 7, 3 },
+    { "14", 2684, 1.1768, 5, 3 },
+    { "1", 4200, 0.888701, 3, 2 },
+};
+
+const std::map<std::string_view, std::vector<std::string>> BASELINE_STOP_BUSES = {
+    { "Tolstopaltsevo", { "750" } },
+    { "Marushkino", { "750" } },
+    { "Rasskazovka", { "750" } },
+    { "Biryulyovo Zapadnoye", { "256", "828" } },
+    { "Biryusinka", { "1", "256", "Экспресс" } },
+    { "Universam", { "14", "256", "828", "Экспресс" } },
+    { "Biryulyovo Tovarnaya", { "14", "256" } },
+    { "Biryulyovo Passazhirskaya", { "256" } },
+    { "Rossoshanskaya ulitsa", { "828" } },
+    { "Prazhskaya", {} },
+    { "Улица Лизы Чайкиной", { "1", "Экспресс" } },
+    { "Biryu", { "14" } },
+};
+
+// Stored the way JsonReader stores them: the other buses go there and back
+std::vector<std::string_view> MakeRoute(const BusData& bus) {
+    std::vector<std::string_view> stops = bus.stops;
+    if (!bus.is_roundtrip) {
+        stops.insert(stops.end(), bus.stops.rbegin() + 1, bus.stops.rend());
+    }
+    return stops;
+}
+
+void AddBus(TransportCatalogue& catalogue, const BusData& bus) {
+    catalogue.AddBus(bus.name, MakeRoute(bus), bus.is_roundtrip);
+}
+
+// In the order of JsonReader: the stops, their distances, then the buses
+void FillCatalogue(TransportCatalogue& catalogue) {
+    for (const auto& stop : STOPS) {
+        catalogue.AddStop(stop.name, stop.coordinates);
+    }
+    for (const auto& stop : STOPS) {
+        for (const auto& [to, distance] : stop.road_distances) {
+            catalogue.SetDistance(catalogue.FindStop(stop.name)->id, catalogue.FindStop(to)->id, distance);
+        }
+    }
+    for (const auto& bus : BUSES) {
+        AddBus(catalogue, bus);
+    }
+}
+
+// For the catalogue and its frozen copies
+template <typename Catalogue>
+std::vector<std::string> GetStopBusNames(const Catalogue& catalogue, std::string_view stop) {
+    std::vector<std::string> names;
+    for (const BusId bus : catalogue.GetStopInfo(stop)) {
+        names.emplace_back(catalogue.GetBus(bus).name);
+    }
+    return names;
+}
+
+// A stop lists every bus name once: a bus named again is refused, a removed one may come back
+void TestBusNamedAgain() {
+    TransportCatalogue catalogue;
+    catalogue.AddStop("A", { 55.60, 37.20 });
+    catalogue.AddStop("B", { 55.61, 37.21 });
+    catalogue.AddBus("1", { "A", "B", "A" }, false);
+
+    bool is_refused = false;
+    try {
+        catalogue.AddBus("1", { "B", "A", "B" }, false);
+    }
+    catch (const std::invalid_argument&) {
+        is_refused = true;
+    }
+    CHECK(is_refused);
+    CHECK(GetStopBusNames(catalogue, "A") == std::vector<std::string>{ "1" });
+    CHECK(GetStopBusNames(catalogue, "B") == std::vector<std::string>{ "1" });
+
+    catalogue.RemoveBus("1");
+    CHECK(GetStopBusNames(catalogue, "A").empty());
+    catalogue.AddBus("1", { "B", "B" }, true);
+    CHECK(GetStopBusNames(catalogue, "A").empty());
+    CHECK(GetStopBusNames(catalogue, "B") == std::vector<std::string>{ "1" });
+    CHECK(catalogue.FindBus("1")->route.size() == 2);
+}
+
+template <typename Catalogue>
+void CheckBaselineStats(const Catalogue& catalogue) {
+    for (const auto& expected : BASELINE_BUS_INFOS) {
+        const auto info = catalogue.GetBusInfo(expected.name);
+        CHECK(info.route_distance == expected.route_length);
+        CHECK(std::abs(info.route_distance / info.geo_distance - expected.curvature) <= 1e-5 * expected.curvature);
+        CHECK(info.stops == expected.stop_count);
+        CHECK(info.unique_stop == expected.unique_stop_count);
+    }
+    for (const auto& [stop, buses] : BASELINE_STOP_BUSES) {
+        CHECK(GetStopBusNames(catalogue, stop) == buses);
+    }
+    CHECK(catalogue.FindBus("751") == nullptr);
+    CHECK(catalogue.FindStop("Samara") == nullptr);
+    CHECK(catalogue.GetStopInfo("Samara").empty());
+}
+
+// The stats are the same computed on demand and after Finalize, on any number of threads, and in the frozen copy
+void TestBaselineStats() {
+    for (const size_t thread_count : { 1, 4 }) {
+        TransportCatalogue catalogue;
+        FillCatalogue(catalogue);
+        CheckBaselineStats(catalogue);
+        catalogue.Finalize(thread_count);
+        CheckBaselineStats(catalogue);
+        CheckBaselineStats(FrozenCatalogue(catalogue));
+    }
+}
+
+// The distances set and the buses added or removed after Finalize bring the stats of the buses they touch up to date,
+// made directly or through a VersionedCatalogue, whose next version copies only what they touch
+void TestStatsAfterFinalize(bool is_versioned) {
+    TransportCatalogue catalogue;
+    for (const auto& stop : STOPS) {
+        catalogue.AddStop(stop.name, stop.coordinates);
+    }
+    // The other stops do not set the way back to Universam, so its row may come last
+    const auto set_distances = [&catalogue](bool is_late, auto& editor) {
+        for (const auto& stop : STOPS) {
+            if ((stop.name == "Universam") != is_late) {
+                continue;
+            }
+            for (const auto& [to, distance] : stop.road_distances) {
+                editor.SetDistance(catalogue.FindStop(stop.name)->id, catalogue.FindStop(to)->id, distance);
+            }
+        }
+    };
+    set_distances(false, catalogue);
+    for (const auto& bus : BUSES) {
+        if (bus.name != "828") {
+            AddBus(catalogue, bus);
+        }
+    }
+    catalogue.AddBus("999", { "Biryu", "Prazhskaya", "Biryu" }, true);
+    catalogue.Finalize();
+
+    // The distances go last and alone, so the version they make has to copy the buses they change by itself
+    const auto change_buses = [&](auto& editor) {
+        editor.AddBus(BUSES[2].name, MakeRoute(BUSES[2]), BUSES[2].is_roundtrip);
+        editor.RemoveBus("999");
+    };
+    const auto change_distances = [&](auto& editor) {
+        set_distances(true, editor);
+    };
+    if (is_versioned) {
+        VersionedCatalogue versioned(catalogue);
+        versioned.Update([&](VersionedCatalogue::Editor& editor) { change_buses(editor); });
+        versioned.Update([&](VersionedCatalogue::Editor& editor) { change_distances(editor); });
+        CheckBaselineStats(*versioned.Pin());
+    }
+    else {
+        change_buses(catalogue);
+        change_distances(catalogue);
+    }
+    CheckBaselineStats(catalogue);
+}
+
+}  // namespace
+
+int main() {
+    TestBusNamedAgain();
+    TestBaselineStats();
+    TestStatsAfterFinalize(false);
+    TestStatsAfterFinalize(true);
+    return testing::Finish();
+}
@@ -0,0 +1,261 @@
+#include "json.h"
+#include "json_reader.h"
+#include "testing.h"
+#include "transport_catalogue.h"
+#include "versioned_catalogue.h"
+
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using transport_catalogue::FrozenCatalogue;
+using transport_catalogue::TransportCatalogue;
+using transport_catalogue::VersionedCatalogue;
+
+namespace {
+
+// More than one chunk of stops and of buses. The buses pass only the first half of the stops
+const int STOP_COUNT = 150;
+const int BUS_COUNT = 100;
+const int UPDATE_COUNT = 300;
+const int READER_COUNT = 4;
+
+void CheckSameCatalogue(const FrozenCatalogue& lhs, const FrozenCatalogue& rhs, const TransportCatalogue& catalogue) {
+    CHECK(lhs.GetStopCount() == rhs.GetStopCount());
+    CHECK(lhs.GetBusCount() == rhs.GetBusCount());
+    for (StopId from = 0; from < catalogue.GetStopCount(); ++from) {
+        const auto name = catalogue.GetStop(from).name;
+        CHECK(lhs.FindStop(name) != nullptr && rhs.FindStop(name) != nullptr && lhs.FindStop(name)->id == rhs.FindStop(name)->id);
+        const auto lhs_buses = lhs.GetStopInfo(name);
+        const auto rhs_buses = rhs.GetStopInfo(name);
+        CHECK(std::equal(lhs_buses.begin(), lhs_buses.end(), rhs_buses.begin(), rhs_buses.end()));
+        for (StopId to = 0; to < catalogue.GetStopCount(); ++to) {
+            CHECK(lhs.GetDistance(from, to) == rhs.GetDistance(from, to));
+        }
+    }
+    for (BusId id = 0; id < catalogue.GetBusCount(); ++id) {
+        const auto name = catalogue.GetBus(id).name;
+        const auto* lhs_bus = lhs.FindBus(name);
+        const auto* rhs_bus = rhs.FindBus(name);
+        CHECK((lhs_bus == nullptr) == (rhs_bus == nullptr));
+        if (lhs_bus != nullptr && rhs_bus != nullptr) {
+            CHECK(lhs_bus->id == rhs_bus->id);
+            CHECK(std::equal(lhs_bus->route.begin(), lhs_bus->route.end(), rhs_bus->route.begin(), rhs_bus->route.end()));
+            const auto lhs_info = lhs.GetBusInfo(name);
+            const auto rhs_info = rhs.GetBusInfo(name);
+            CHECK(lhs_info.stops == rhs_info.stops && lhs_info.unique_stop == rhs_info.unique_stop);
+            CHECK(lhs_info.route_distance == rhs_info.route_distance && lhs_info.geo_distance == rhs_info.geo_distance);
+        }
+    }
+}
+
+// Every update sets the distance from S0 to S1 to one more and adds the bus named after the previous distance; the way
+// back stays as the first distance set it. A reader has to see each update whole: the stats of the line over S0 and S1
+// and the buses agree with the distance
+void TestConcurrentReaders() {
+    std::mt19937 generator(11);
+    TransportCatalogue catalogue;
+    for (int i = 0; i < STOP_COUNT; ++i) {
+        catalogue.AddStop("S" + std::to_string(i), { 55.0 + std::uniform_real_distribution<>(0, 0.05)(generator),
+                                                     37.0 + std::uniform_real_distribution<>(0, 0.05)(generator) });
+    }
+    catalogue.SetDistance(0, 1, 1);
+    catalogue.AddBus("Line", { "S0", "S1", "S0" }, false);
+    for (int i = 0; i < BUS_COUNT; ++i) {
+        std::vector<std::string_view> stops;
+        for (int j = 0; j < 5; ++j) {
+            stops.push_back(catalogue.GetStop(2 + generator() % (STOP_COUNT / 2)).name);
+        }
+        stops.push_back(stops.front());
+        catalogue.AddBus("B" + std::to_string(i), stops, true);
+    }
+    catalogue.Finalize();
+
+    VersionedCatalogue versioned(catalogue);
+    auto first = versioned.Pin();
+    const size_t first_bus_count = first->GetBusCount();
+
+    std::atomic<bool> is_done = false;
+    std::atomic<int> pin_count = 0;
+    // CHECK is not for other threads, the readers only count what they found wrong
+    std::atomic<int> torn_count = 0;
+    std::vector<std::thread> readers;
+    for (int reader = 0; reader < READER_COUNT; ++reader) {
+        readers.emplace_back([&, reader] {
+            // Now and then a version is held over the next pins, so it is let go after it was replaced
+            auto held = versioned.Pin();
+            for (int i = 0; !is_done.load(); ++i) {
+                const auto version = versioned.Pin();
+                const int distance = version->GetDistance(0, 1);
+                if (version->GetBusInfo("Line").route_distance != distance + 1 || version->GetDistance(1, 0) != 1
+                    || version->FindBus("V" + std::to_string(distance)) != nullptr
+                    || (distance > 1 && version->FindBus("V" + std::to_string(distance - 1)) == nullptr)
+                    || held->GetDistance(0, 1) > distance) {
+                    ++torn_count;
+                }
+                if (i % (reader + 2) == 0) {
+                    held = versioned.Pin();
+                }
+                ++pin_count;
+            }
+        });
+    }
+
+    for (int update = 1; update <= UPDATE_COUNT; ++update) {
+        versioned.Update([&](VersionedCatalogue::Editor& editor) {
+            editor.SetDistance(0, 1, update + 1);
+            editor.AddBus("V" + std::to_string(update), { "S0", "S1", "S0" }, false);
+            if (update % 3 == 0) {
+                editor.RemoveBus("B" + std::to_string(generator() % BUS_COUNT));
+            }
+            if (update % 5 == 0) {
+                const std::string name = "N" + std::to_string(update);
+                editor.AddStop(name, { 55.0, 37.0 });
+                // The way back is set in a chunk no other change touches
+                editor.SetDistance(editor.GetCatalogue().FindStop(name)->id, STOP_COUNT - 1, 100);
+            }
+        });
+    }
+    is_done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    CHECK(pin_count.load() > 0);
+    CHECK(torn_count.load() == 0);
+
+    // The first version did not change under the updates
+    CHECK(first->GetDistance(0, 1) == 1);
+    CHECK(first->GetBusInfo("Line").route_distance == 2);
+    CHECK(first->FindBus("V1") == nullptr);
+    CHECK(first->GetBusCount() == first_bus_count);
+
+    // The last version, made of chunks shared along the updates, is the catalogue copied from scratch
+    CheckSameCatalogue(*versioned.Pin(), FrozenCatalogue(catalogue), catalogue);
+}
+
+std::string MakeInput(const std::string& engine, const std::string& base_requests, const std::string& stat_requests) {
+    return R"({"base_requests": [)" + base_requests + R"(], "render_settings": {}, "routing_settings": )"
+           R"({"bus_wait_time": 6, "bus_velocity": 40, "router_engine": ")" + engine + R"("}, "stat_requests": [)" + stat_requests + "]}";
+}
+
+json::Array GetAnswers(const std::string& input) {
+    std::istringstream in(input);
+    JsonReader reader(in);
+    TransportCatalogue catalogue;
+    reader.ParseData(catalogue);
+    std::ostringstream out;
+    reader.PrintResult(out);
+    std::istringstream result(out.str());
+    return json::Load(result).GetRoot().AsArray();
+}
+
+const std::string STOPS = R"({"type": "Stop", "name": "A", "latitude": 55.60, "longitude": 37.20, "road_distances": {"B": 3000}},)"
+                          R"({"type": "Stop", "name": "B", "latitude": 55.61, "longitude": 37.21, "road_distances": {"C": 2000}},)"
+                          R"({"type": "Stop", "name": "C", "latitude": 55.62, "longitude": 37.22, "road_distances": {"D": 4000}},)"
+                          R"({"type": "Stop", "name": "D", "latitude": 55.63, "longitude": 37.23, "road_distances": {"A": 5000}},)";
+const std::string BUSES = R"({"type": "Bus", "name": "1", "stops": ["A", "B", "C"], "is_roundtrip": false},)"
+                          R"({"type": "Bus", "name": "2", "stops": ["C", "D", "A", "C"], "is_roundtrip": true},)"
+                          R"({"type": "Bus", "name": "3", "stops": ["B", "D"], "is_roundtrip": false})";
+const char* const ENGINE_NAMES[] = { "floyd_warshall", "tiled_floyd_warshall", "dijkstra", "contraction_hierarchies", "alt", "raptor" };
+
+// Every Bus and Stop request and the routes between every pair of the stops, each starting with a comma
+std::string MakeQueries() {
+    std::string queries;
+    int id = 100;
+    for (const std::string bus : { "1", "2", "3", "4", "5" }) {
+        queries += R"(, {"id": )" + std::to_string(id++) + R"(, "type": "Bus", "name": ")" + bus + R"("})";
+    }
+    for (const std::string stop : { "A", "B", "C", "D", "E" }) {
+        queries += R"(, {"id": )" + std::to_string(id++) + R"(, "type": "Stop", "name": ")" + stop + R"("})";
+        for (const std::string to : { "A", "B", "C", "D", "E" }) {
+            queries += R"(, {"id": )" + std::to_string(id++) + R"(, "type": "Route", "from": ")" + stop + R"(", "to": ")" + to + R"("})";
+        }
+    }
+    return queries;
+}
+
+// The answers after the first skipped ones are the expected ones, the route times up to rounding
+void CheckSameAnswers(const json::Array& answers, size_t skipped, const json::Array& expected_answers) {
+    CHECK(answers.size() == expected_answers.size() + skipped);
+    for (size_t i = 0; i < expected_answers.size() && i + skipped < answers.size(); ++i) {
+        const auto& answer = answers[i + skipped].AsMap();
+        const auto& expected = expected_answers[i].AsMap();
+        if (const auto it = expected.find("total_time"); it != expected.end()) {
+            CHECK(answer.count("total_time") > 0 && std::abs(answer.at("total_time").AsDouble() - it->second.AsDouble()) < 1e-9);
+        }
+        else {
+            CHECK(answer == expected);
+        }
+    }
+}
+
+// The answers after an Update are those of the catalogue loaded with the changes in the first place.
+// The Update comes right after the load, while the router is still being built on the other thread.
+// The buses are changed in the order of the request: bus 5 is added and then removed
+void TestUpdateRequest() {
+    const std::string new_stop = R"({"type": "Stop", "name": "E", "latitude": 55.64, "longitude": 37.24, "road_distances": {"A": 700}},)";
+    const std::string changed_stops = new_stop + R"({"type": "Stop", "name": "B", "latitude": 55.61, "longitude": 37.21, "road_distances": {"C": 900}},)";
+    const std::string changed_buses = R"({"type": "Bus", "name": "2", "stops": ["E", "A", "D"], "is_roundtrip": false},)"
+                                      R"({"type": "Bus", "name": "4", "stops": ["E", "C"], "is_roundtrip": false})";
+    // The stops of the first load with the new distance from B; the way back stays as the first load set it
+    const std::string updated_stops = R"({"type": "Stop", "name": "A", "latitude": 55.60, "longitude": 37.20, "road_distances": {"B": 3000}},)"
+                                      R"({"type": "Stop", "name": "B", "latitude": 55.61, "longitude": 37.21, "road_distances": {"C": 900}},)"
+                                      R"({"type": "Stop", "name": "C", "latitude": 55.62, "longitude": 37.22, "road_distances": {"B": 2000, "D": 4000}},)"
+                                      R"({"type": "Stop", "name": "D", "latitude": 55.63, "longitude": 37.23, "road_distances": {"A": 5000}},)";
+    const std::string updated_buses = R"({"type": "Bus", "name": "1", "stops": ["A", "B", "C"], "is_roundtrip": false},)" + changed_buses;
+    const std::string queries = MakeQueries();
+
+    for (const std::string engine : ENGINE_NAMES) {
+        const std::string update = R"({"id": 1, "type": "Update", "base_requests": [)" + changed_stops +
+                                   R"({"type": "Bus", "name": "5", "stops": ["A", "D"], "is_roundtrip": false},)"
+                                   R"({"type": "RemoveBus", "name": "3"},)" + changed_buses +
+                                   R"(, {"type": "RemoveBus", "name": "5"}]})";
+        const auto updated = GetAnswers(MakeInput(engine, STOPS + BUSES, update + queries));
+        const auto fresh = GetAnswers(MakeInput(engine, new_stop + updated_stops + updated_buses, queries.substr(1)));
+
+        CHECK(!updated.empty() && updated.front() == json::Node(json::Dict{ { "request_id", 1 } }));
+        CheckSameAnswers(updated, 1, fresh);
+    }
+}
+
+// A bad Update is answered with an error and changes nothing, not even the parts of it that are right
+void TestInvalidUpdate() {
+    const std::string updates[] = {
+        R"({"id": 1, "type": "Update", "base_requests": [{"type": "Stop", "name": "E", "latitude": 55.64, "longitude": 37.24},)"
+        R"({"type": "RemoveBus", "name": "1"}, {"type": "Stop", "name": "B", "latitude": 55.61, "longitude": 37.21, "road_distances": {"X": 10}}]})",
+        R"({"id": 2, "type": "Update", "base_requests": [{"type": "RemoveBus", "name": "1"},)"
+        R"({"type": "Bus", "name": "4", "stops": ["A", "X"], "is_roundtrip": true}]})",
+        R"({"id": 3, "type": "Update", "base_requests": [{"type": "RemoveBus", "name": "1"},)"
+        R"({"type": "Bus", "name": "4", "stops": [], "is_roundtrip": false}]})",
+        R"({"id": 4, "type": "Update", "base_requests": [{"type": "RemoveBus", "name": "1"}, {"type": "Train", "name": "4"}]})",
+    };
+    const std::string queries = MakeQueries();
+
+    for (const std::string engine : ENGINE_NAMES) {
+        std::string requests;
+        for (const auto& update : updates) {
+            requests += (requests.empty() ? "" : ", ") + update;
+        }
+        const auto updated = GetAnswers(MakeInput(engine, STOPS + BUSES, requests + queries));
+        const auto fresh = GetAnswers(MakeInput(engine, STOPS + BUSES, queries.substr(1)));
+
+        for (int id = 1; id <= 4; ++id) {
+            CHECK(static_cast<int>(updated.size()) >= id
+                  && updated[id - 1] == json::Node(json::Dict{ { "request_id", id }, { "error_message", std::string("invalid update") } }));
+        }
+        CheckSameAnswers(updated, 4, fresh);
+    }
+}
+
+}  // namespace
+
+int main() {
+    TestConcurrentReaders();
+    TestUpdateRequest();
+    TestInvalidUpdate();
+    return testing::Finish();
+}